@@ -0,0 +1,94 @@
+// Fields of struct gb_s held by a portable save state (see gb_state_save),
+// in the order they're stored.
+//
+// format: FIELD(member, bytes, condition) -- stored little-endian in the given
+//                                            number of bytes, whatever its type
+//         ARRAY(member, condition)        -- a byte array, stored as-is
+//
+// A field is only stored if its condition holds for the cartridge. Fields
+// which belong to the emulator instance rather than the game (pointers,
+// front-end settings, statistics) or are derived from the ROM are left out,
+// as are caches rebuilt on load.
+
+// CPU
+FIELD(cpu_reg.a, 1, 1)
+FIELD(cpu_reg.f, 1, 1)
+FIELD(cpu_reg.b, 1, 1)
+FIELD(cpu_reg.c, 1, 1)
+FIELD(cpu_reg.d, 1, 1)
+FIELD(cpu_reg.e, 1, 1)
+FIELD(cpu_reg.h, 1, 1)
+FIELD(cpu_reg.l, 1, 1)
+FIELD(cpu_reg.sp, 2, 1)
+FIELD(cpu_reg.pc, 2, 1)
+FIELD(gb_halt, 1, 1)
+FIELD(gb_ime, 1, 1)
+FIELD(gb_bios_enable, 1, 1)
+FIELD(gb_frame, 1, 1)
+
+// IO
+FIELD(gb_reg.P1, 1, 1)
+FIELD(gb_reg.SB, 1, 1)
+FIELD(gb_reg.SC, 1, 1)
+FIELD(gb_reg.DIV, 1, 1)
+FIELD(gb_reg.TIMA, 1, 1)
+FIELD(gb_reg.TMA, 1, 1)
+FIELD(gb_reg.TAC, 1, 1)
+FIELD(gb_reg.IF, 1, 1)
+FIELD(gb_reg.LCDC, 1, 1)
+FIELD(gb_reg.STAT, 1, 1)
+FIELD(gb_reg.SCY, 1, 1)
+FIELD(gb_reg.SCX, 1, 1)
+FIELD(gb_reg.LY, 1, 1)
+FIELD(gb_reg.LYC, 1, 1)
+FIELD(gb_reg.DMA, 1, 1)
+FIELD(gb_reg.BGP, 1, 1)
+FIELD(gb_reg.OBP0, 1, 1)
+FIELD(gb_reg.OBP1, 1, 1)
+FIELD(gb_reg.WY, 1, 1)
+FIELD(gb_reg.WX, 1, 1)
+FIELD(gb_reg.IE, 1, 1)
+FIELD(gb_reg.tac_cycles, 2, 1)
+FIELD(gb_reg.tac_cycles_shift, 1, 1)
+FIELD(gb_reg.tima_overflow_delay, 1, 1)
+FIELD(counter.lcd_count, 4, 1)
+FIELD(counter.div_count, 4, 1)
+FIELD(counter.tima_count, 4, 1)
+FIELD(counter.serial_count, 4, 1)
+FIELD(counter.lcd_off_count, 4, 1)
+ARRAY(hram, 1)
+ARRAY(oam, 1)
+
+// PPU
+FIELD(lcd_mode, 1, 1)
+FIELD(lcd_blank, 1, 1)
+FIELD(lcd_master_enable, 1, 1)
+ARRAY(display.bg_palette, 1)
+ARRAY(display.sp_palette, 1)
+FIELD(display.window_clear, 1, 1)
+FIELD(display.WY, 1, 1)
+
+// MBC
+FIELD(gb_cart_ram_size, 4, 1)  // (checked rather than loaded)
+FIELD(enable_cart_ram, 1, 1)
+FIELD(cart_mode_select, 1, 1)
+FIELD(selected_rom_bank, 2, 1)
+FIELD(cart_ram_bank, 1, 1)
+FIELD(rtc_latch_s1, 1, 1)
+ARRAY(latched_rtc, 1)
+ARRAY(cart_rtc, gb->mbc != 7)
+FIELD(mbc7.ram_enable_1, 1, gb->mbc == 7)
+FIELD(mbc7.ram_enable_2, 1, gb->mbc == 7)
+FIELD(mbc7.accel_latch_state, 1, gb->mbc == 7)
+FIELD(mbc7.accel_x_latched, 2, gb->mbc == 7)
+FIELD(mbc7.accel_y_latched, 2, gb->mbc == 7)
+FIELD(mbc7.eeprom_pins, 1, gb->mbc == 7)
+FIELD(mbc7.eeprom_state, 1, gb->mbc == 7)
+FIELD(mbc7.eeprom_write_enabled, 1, gb->mbc == 7)
+FIELD(mbc7.eeprom_shift_reg, 2, gb->mbc == 7)
+FIELD(mbc7.eeprom_bits_shifted, 1, gb->mbc == 7)
+FIELD(mbc7.eeprom_addr, 1, gb->mbc == 7)
+FIELD(mbc7.eeprom_read_buffer, 2, gb->mbc == 7)
+
+#undef FIELD
+#undef ARRAY
@@ -18,6 +18,14 @@
 #include <stdint.h>
 #include <string.h>
 
+#if defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #define audio_mem(audio) \
     ((uint8_t*)((void*)audio - offsetof(struct gb_s, audio) + offsetof(struct gb_s, hram) + 0x10))
 
@@ -44,6 +52,48 @@
 
 #define MAX_CHAN_VOLUME 15
 
+/* CPU cycles per output sample (at FREQ_INC_REF), 16.16 fixed point. */
+#define AUDIO_CYCLES_PER_SAMPLE ((uint32_t)(((uint64_t)DMG_CLOCK_FREQ_U << 16) / FREQ_INC_REF))
+
+/* Must be a power of two. */
+#define AUDIO_QUEUE_SIZE 2048
+
+/* Output samples the device asks for per audio callback (5.8 ms). */
+#define AUDIO_CALLBACK_LEN 256
+
+/* CPU cycles' worth of audio played out per callback. */
+#define AUDIO_CALLBACK_CYCLES \
+    ((uint32_t)((uint64_t)AUDIO_CALLBACK_LEN * DMG_CLOCK_FREQ_U / FREQ_INC_REF))
+
+/* How far (in CPU cycles) the audio callback trails the emulation, steered
+ * by its average. The emulation delivers a frame at a time (two with frame
+ * skip, which the average covers by half), and the callback takes a
+ * callback's worth at a time; one more callback period is margin for jitter.
+ * About 28 ms in all. */
+#define AUDIO_QUEUE_LATENCY ((uint32_t)(SCREEN_REFRESH_CYCLES + 2 * AUDIO_CALLBACK_CYCLES))
+
+/* If the emulation gets further ahead than this (fast-forward, a stall, or
+ * loading a state), the callback skips forward instead of catching up. */
+#define AUDIO_QUEUE_MAX_LATENCY ((uint32_t)(6 * SCREEN_REFRESH_CYCLES))
+
+/* To hold the latency at its target as the display and audio clocks drift
+ * apart, the callback's clock runs up to 1/AUDIO_RATE_RANGE (0.5%) fast or
+ * slow, in proportion to how far the (smoothed) latency is off target, with
+ * the full adjustment at one frame off. */
+#define AUDIO_RATE_RANGE 200
+
+/* If the latency is more than this (CPU cycles) off target regardless,
+ * audio_frame_correction() asks for a frame to be added or dropped. */
+#define AUDIO_FRAME_CORRECTION_THRESHOLD ((int32_t)SCREEN_REFRESH_CYCLES)
+
+/* Frames to wait after a correction for the latency to settle. */
+#define AUDIO_FRAME_CORRECTION_HOLDOFF 30
+
+/* Internal samples held by the ring that the "Per frame" render mode fills
+ * from the emulation. Must be a power of two, and hold several frames at
+ * 44.1 kHz (735 samples each). */
+#define AUDIO_RING_SIZE 8192
+
 #ifdef TARGET_SIMULATOR
 #define __audio
 #else
@@ -53,7 +103,8 @@
 
 static inline int get_sample_replication(void)
 {
-    // preferences_sample_rate: 0 -> 1 (44.1kHz), 1 -> 2 (22.05kHz)
+    // preferences_sample_rate: 0 -> 1 (44.1kHz), 1 -> 2 (22.05kHz),
+    // 2 -> 3 (14.7kHz), 3 -> 4 (11.025kHz)
     return preferences_sample_rate + 1;
 }
 
@@ -67,6 +118,206 @@ static inline int get_audio_sample_rate(void)
  */
 static uint32_t precomputed_noise_freqs[8][16];
 
+/* Output of the noise channel's LFSR, one bit per clock, from the state it
+ * is triggered in (all ones). A set bit is a low output. Each sequence runs
+ * on past its period by LFSR_SEQ_SLACK bits, so that a window starting
+ * anywhere within the period can be read without wrapping. */
+#define LFSR15_PERIOD 32767
+#define LFSR7_PERIOD 127
+#define LFSR_SEQ_SLACK 64
+#define LFSR_SEQ_WORDS(period) (((period) + LFSR_SEQ_SLACK + 31) / 32 + 1)
+
+static uint32_t lfsr15_seq[LFSR_SEQ_WORDS(LFSR15_PERIOD)];
+static uint32_t lfsr7_seq[LFSR_SEQ_WORDS(LFSR7_PERIOD)];
+
+struct audio_write_entry
+{
+    uint32_t cycle;
+    uint16_t addr;
+    uint8_t val;
+};
+
+/**
+ * Register writes in flight from the emulation (producer) to the audio
+ * callback (consumer). Lock-free; head is only written by the producer and
+ * tail only by the consumer. The producer discards the writes in flight by
+ * asking the consumer to skip them (see audio_queue_reset).
+ *
+ * This lives outside of gb_s so that it is unaffected by the front-end
+ * copying gb_s to and from the stack.
+ */
+static struct
+{
+    struct audio_write_entry entries[AUDIO_QUEUE_SIZE];
+    uint32_t head;
+    uint32_t tail;
+
+    // the producer bumps reset_epoch to have the consumer skip its tail
+    // ahead to reset_head; reset_seen is the consumer's copy of the epoch
+    uint32_t reset_head;
+    uint32_t reset_epoch;
+    uint32_t reset_seen;
+
+    // all writes before this timestamp have been queued
+    uint32_t producer_cycle;
+
+    // consumer's clock: timestamp of the next sample to be rendered
+    uint32_t cycle;
+    uint32_t cycle_frac;
+    bool synced;
+
+    // CPU cycles the consumer's clock advances per output sample (16.16),
+    // adjusted around AUDIO_CYCLES_PER_SAMPLE to follow the emulation
+    uint32_t cycles_per_sample;
+
+    // the callback's current rate adjustment (16.16 CPU cycles per sample)
+    int32_t rate_adjust;
+
+    // distance behind the emulation (CPU cycles), smoothed across callbacks
+    int32_t latency;
+
+    // if set, the writes are consumed (and the audio rendered) by the
+    // emulation in audio_sync(), and the callback only plays out audio_ring
+    bool main_thread;
+
+    // times the consumer had to resync, because it caught up with the
+    // emulation (underrun) or fell too far behind it (overrun)
+    uint32_t underruns;
+    uint32_t overruns;
+
+    // NR52 channel-status bits, as last computed by the consumer
+    uint8_t status;
+
+    // writes which didn't fit in the queue
+    uint32_t overflows;
+
+    // registers (bit n: 0xFF10 + n) with writes which didn't fit in the
+    // queue, set by the producer. Until the consumer has caught up and
+    // reloaded them from the CPU's view (see audio_queue_reload), further
+    // writes are left to the reload too, so that none is applied out of order.
+    uint32_t dropped[2];
+
+    // likewise, channels (bit n: channel n) triggered by a dropped write to
+    // NRx4, which may since have been overwritten without the trigger bit
+    uint32_t dropped_triggers;
+
+    audio_data* audio;
+} audio_queue;
+
+/* While the emulation holds the synthesiser (see audio_hold), the callback
+ * leaves it alone. On the simulator this is audio_mutex; on the device the
+ * callback marks itself busy while it runs, and backs off if it finds the
+ * synthesiser held. */
+#ifndef TARGET_SIMULATOR
+static bool audio_held;
+static bool audio_busy;
+#endif
+
+// Keeps the audio callback away from the synthesiser and audio_queue, e.g.
+// to replace its state; waits for a callback in progress to finish. The
+// calling thread may then stand in for the consumer.
+static void audio_hold(void)
+{
+#ifdef TARGET_SIMULATOR
+    pthread_mutex_lock(&audio_mutex);
+#else
+    __atomic_store_n(&audio_held, true, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&audio_busy, __ATOMIC_SEQ_CST))
+        ;
+#endif
+}
+
+static void audio_release(void)
+{
+#ifdef TARGET_SIMULATOR
+    pthread_mutex_unlock(&audio_mutex);
+#else
+    __atomic_store_n(&audio_held, false, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/* Internal (not output) samples rendered per chunk of the callback. */
+#define AUDIO_MAX_CHUNK 256
+
+/* A stereo sample, packed as two int16 halves (left in the low half) so that
+ * both sides are mixed with a single dual 16-bit add. */
+typedef uint32_t stereo_t;
+
+/* Each chunk is rendered (or, in Accurate mode, integrated) here before it
+ * is split into the left and right output buffers, or copied to audio_ring;
+ * indexed by internal sample. */
+static stereo_t audio_mix[AUDIO_MAX_CHUNK];
+
+/* At the reduced sample rates, the output is interpolated from the last
+ * internal sample that was written out towards the next. */
+static stereo_t upsample_prev;
+
+/**
+ * Internal samples rendered ahead by the emulation, in the "Per frame"
+ * render mode. Lock-free like audio_queue; head is only written by the
+ * emulation and tail only by the callback.
+ */
+static struct
+{
+    stereo_t samples[AUDIO_RING_SIZE];
+    uint32_t head;
+    uint32_t tail;
+
+    // the callback's read position between prev and next (16.16 samples)
+    uint32_t frac;
+    stereo_t prev;
+    stereo_t next;
+
+    // set after running dry, until the ring has refilled to its target
+    bool priming;
+} audio_ring;
+
+/* Band-limited step synthesis, used by the "Accurate" sound mode.
+ *
+ * Each change in a channel's output level is added to blep_accum as a
+ * band-limited impulse at its sub-sample position, from a table of windowed
+ * sinc kernels (8 taps, 16 phases). All channels share the buffer, and the
+ * output is its running sum. The kernels are scaled so that every phase sums
+ * to exactly 1 << BLEP_SCALE_BITS, so the sum can't drift. */
+#define BLEP_TAPS 8
+#define BLEP_PHASE_BITS 4
+#define BLEP_SCALE_BITS 14
+
+/* clang-format off */
+static const int16_t blep_kernel[1 << BLEP_PHASE_BITS][BLEP_TAPS] = {
+    {9, 92, -1008, 9098, 9100, -1008, 92, 9},
+    {4, 124, -1089, 8234, 9915, -866, 46, 16},
+    {1, 144, -1117, 7337, 10663, -656, -12, 24},
+    {-2, 154, -1100, 6426, 11328, -372, -85, 35},
+    {-3, 156, -1046, 5519, 11894, -11, -172, 47},
+    {-3, 151, -964, 4631, 12348, 431, -272, 62},
+    {-3, 141, -862, 3779, 12681, 953, -383, 78},
+    {-3, 127, -746, 2975, 12883, 1555, -501, 94},
+    {-2, 111, -624, 2231, 12950, 2231, -624, 111},
+    {-2, 94, -501, 1555, 12882, 2975, -746, 127},
+    {-1, 78, -383, 953, 12679, 3779, -862, 141},
+    {-1, 62, -272, 431, 12346, 4631, -964, 151},
+    {0, 47, -172, -11, 11891, 5519, -1046, 156},
+    {0, 35, -85, -372, 11326, 6426, -1100, 154},
+    {0, 24, -12, -656, 10664, 7337, -1117, 144},
+    {0, 16, 46, -866, 9919, 8234, -1089, 124},
+};
+/* clang-format on */
+
+struct blep_frame
+{
+    int32_t left;
+    int32_t right;
+};
+
+// indexed by internal (not output) sample
+static struct blep_frame blep_accum[AUDIO_MAX_CHUNK + BLEP_TAPS];
+static struct blep_frame blep_sum;
+
+// set while every channel is panned to the centre (at equal volumes), so
+// that only the left side need be mixed; see mix_centred.
+static bool mix_mono;
+
 __audio static void set_note_freq(struct chan* c, const uint32_t freq)
 {
     /* Lowest expected value of freq is 64. */
@@ -79,10 +330,16 @@ static void chan_enable(audio_data* audio, const uint_fast8_t i, const bool enab
     uint8_t val;
     struct chan* chans = audio->chans;
     chans[i].enabled = enable;
-    val = (audio_mem(audio)[0xFF26 - AUDIO_ADDR_COMPENSATION] & 0x80) | (chans[3].enabled << 3) |
+    val = (audio->regs[0xFF26 - AUDIO_ADDR_COMPENSATION] & 0x80) | (chans[3].enabled << 3) |
           (chans[2].enabled << 2) | (chans[1].enabled << 1) | (chans[0].enabled << 0);
 
-    audio_mem(audio)[0xFF26 - AUDIO_ADDR_COMPENSATION] = val;
+    audio->regs[0xFF26 - AUDIO_ADDR_COMPENSATION] = val;
+
+    // (not from a copy, e.g. the one audio_state_save brings up to date)
+    if (audio == audio_queue.audio)
+    {
+        __atomic_store_n(&audio_queue.status, val & 0x0F, __ATOMIC_RELAXED);
+    }
 }
 
 __audio static void update_env(struct chan* c, int sample_rate)
@@ -113,39 +370,171 @@ __audio static int update_len(audio_data* restrict audio, struct chan* c, int le
     if (!c->len_enabled || c->len.inc == 0)
         return len;
 
+    // the counter runs at the internal sample rate, not the output rate
+    int sample_replication = get_sample_replication();
     int sample_rate = get_audio_sample_rate();
+    int samples = (len + sample_replication - 1) / sample_replication;
     int tr = (sample_rate - c->len.counter) / c->len.inc;
 
-    if (tr > len)
+    if (tr > samples)
     {
-        c->len.counter += len * c->len.inc;
+        c->len.counter += samples * c->len.inc;
         return len;
     }
     else
     {
         c->len.counter = 0;
         chan_enable(audio, c - audio->chans, 0);
-        return tr;
+        return tr * sample_replication;
     }
 }
 
-// This function is only for the "Accurate" mode.
-__audio static bool update_freq(struct chan* c, uint32_t* pos, int sample_rate)
+// number of further samples for which a counter advancing by "inc" per
+// sample stays at or below sample_rate, i.e. before its next event.
+__audio static inline int quiet_samples(const uint32_t counter, const uint32_t inc, int sample_rate)
 {
-    uint32_t inc = c->freq_inc - *pos;
-    c->freq_counter += inc;
+    if (inc == 0 || counter > (uint32_t)sample_rate)
+        return INT32_MAX;
 
-    if (c->freq_counter > sample_rate)
+    return (sample_rate - counter) / inc;
+}
+
+// length of the run beginning at this sample, during which the envelope
+// (and sweep) stay constant. Advances their counters to the end of the run.
+__audio static int begin_run(struct chan* c, const bool sweep, int remaining, int sample_rate)
+{
+    int run = remaining;
+
+    int quiet = quiet_samples(c->env.counter, c->env.inc, sample_rate);
+    if (quiet < run - 1)
+        run = quiet + 1;
+
+    if (sweep)
     {
-        *pos = c->freq_inc - (c->freq_counter - sample_rate);
-        c->freq_counter = 0;
-        return true;
+        quiet = quiet_samples(c->sweep.counter, c->sweep.inc, sample_rate);
+        if (quiet < run - 1)
+            run = quiet + 1;
+        c->sweep.counter += (run - 1) * c->sweep.inc;
+    }
+
+    c->env.counter += (run - 1) * c->env.inc;
+    return run;
+}
+
+__audio static inline int32_t clamp16(const int32_t x)
+{
+    return x > INT16_MAX ? INT16_MAX : x < INT16_MIN ? INT16_MIN : x;
+}
+
+__audio static inline stereo_t stereo_pack(const int32_t left, const int32_t right)
+{
+    return (uint16_t)left | ((uint32_t)(uint16_t)right << 16);
+}
+
+__audio static inline int32_t stereo_left(const stereo_t s)
+{
+    return (int16_t)(s & 0xFFFF);
+}
+
+__audio static inline int32_t stereo_right(const stereo_t s)
+{
+    return (int16_t)(s >> 16);
+}
+
+// adds both halves, saturating
+__audio static inline stereo_t stereo_add(const stereo_t a, const stereo_t b)
+{
+#if defined(__ARM_FEATURE_SIMD32)
+    return __qadd16(a, b);
+#elif defined(__SSE2__)
+    return _mm_cvtsi128_si32(_mm_adds_epi16(_mm_cvtsi32_si128(a), _mm_cvtsi32_si128(b)));
+#elif defined(__ARM_NEON)
+    int16x4_t sum =
+        vqadd_s16(vreinterpret_s16_u32(vdup_n_u32(a)), vreinterpret_s16_u32(vdup_n_u32(b)));
+    return vget_lane_u32(vreinterpret_u32_s16(sum), 0);
+#else
+    return stereo_pack(
+        clamp16(stereo_left(a) + stereo_left(b)), clamp16(stereo_right(a) + stereo_right(b))
+    );
+#endif
+}
+
+// averages both halves (rounding down)
+__audio static inline stereo_t stereo_halve_sum(const stereo_t a, const stereo_t b)
+{
+#if defined(__ARM_FEATURE_SIMD32)
+    return __shadd16(a, b);
+#else
+    return stereo_pack(
+        (stereo_left(a) + stereo_left(b)) >> 1, (stereo_right(a) + stereo_right(b)) >> 1
+    );
+#endif
+}
+
+// true if the channel is panned away from both sides (or they are at zero)
+__audio static inline bool chan_silent(const struct chan* c)
+{
+    return (c->gain_left | c->gain_right) == 0;
+}
+
+// contribution of a channel sample to the mix
+__audio static inline stereo_t mix_level(const struct chan* c, const int32_t sample)
+{
+    return stereo_pack(sample * c->gain_left, sample * c->gain_right);
+}
+
+// advances a channel's clock by n samples without rendering anything;
+// returns the number of clocks that elapsed.
+__audio static uint32_t skip_clocks(struct chan* c, int n, int sample_rate)
+{
+    uint32_t counter = c->freq_counter + n * (c->freq_inc % sample_rate);
+    c->freq_counter = counter % sample_rate;
+    return n * (c->freq_inc / sample_rate) + counter / sample_rate;
+}
+
+// time until the channel's next clock, in 16.16 samples
+__audio static inline uint64_t blep_first_clock(const struct chan* c, int sample_rate)
+{
+    return ((uint64_t)(sample_rate - c->freq_counter) << 16) / c->freq_inc;
+}
+
+// stores the clock phase back after a run of n samples ending at clock time t
+__audio static inline void blep_end_run(struct chan* c, uint64_t t, int n, int sample_rate)
+{
+    c->freq_counter = sample_rate - (uint32_t)(((t - ((uint64_t)n << 16)) * c->freq_inc) >> 16);
+}
+
+// moves the channel's output to "level" at time t (16.16 samples into accum)
+__audio static inline void blep_set_level(
+    struct chan* c, struct blep_frame* accum, const uint32_t t, const stereo_t level
+)
+{
+    if (level == c->blep_level)
+        return;
+
+    const int16_t* kernel =
+        blep_kernel[(t >> (16 - BLEP_PHASE_BITS)) & ((1 << BLEP_PHASE_BITS) - 1)];
+    int32_t delta_left = stereo_left(level) - stereo_left(c->blep_level);
+    int32_t delta_right = stereo_right(level) - stereo_right(c->blep_level);
+    accum += t >> 16;
+
+    if (mix_mono)
+    {
+        for (int k = 0; k < BLEP_TAPS; ++k)
+        {
+            accum[k].left += delta_left * kernel[k];
+        }
     }
     else
     {
-        *pos = c->freq_inc;
-        return false;
+        for (int k = 0; k < BLEP_TAPS; ++k)
+        {
+            accum[k].left += delta_left * kernel[k];
+            accum[k].right += delta_right * kernel[k];
+        }
     }
+
+    c->blep_level = level;
 }
 
 __audio static void update_sweep(struct chan* c, int sample_rate)
@@ -179,300 +568,545 @@ __audio static void update_sweep(struct chan* c, int sample_rate)
     }
 }
 
-__audio static void update_square(
-    audio_data* restrict audio, int16_t* buffer, const bool ch2, int len
+__audio static void square_run_blep(
+    audio_data* restrict audio, struct chan* c, struct blep_frame* accum, int n, int sample_rate
 )
 {
-    struct chan* c = audio->chans + ch2;
-
-    if (!c->powered || !c->enabled)
-        return;
+    const unsigned duty = c->square.duty;
+    unsigned duty_counter = c->square.duty_counter;
 
-    uint32_t freq = DMG_CLOCK_FREQ_U / ((2048 - c->freq) << 5);
-    set_note_freq(c, freq);
-    c->freq_inc *= 8;
-
-    if (preferences_sound_mode != 2)
+    stereo_t hi = 0;
+    stereo_t lo = 0;
+    if (!c->muted)
     {
-        if (c->freq_inc == 0)
-            return;
+        hi = mix_level(c, (VOL_INIT_MAX / MAX_CHAN_VOLUME * c->volume) >> 2);
+        lo = mix_level(c, (VOL_INIT_MIN / MAX_CHAN_VOLUME * c->volume) >> 2);
     }
 
-    len = update_len(audio, c, len);
-    int sample_replication = get_sample_replication();
-    int sample_rate = get_audio_sample_rate();
+    blep_set_level(c, accum, 0, ((duty >> duty_counter) & 1) ? hi : lo);
 
-    for (uint_fast16_t i = 0; i < len; i += sample_replication)
+    if (hi == lo)
     {
-        update_env(c, sample_rate);
-        if (!ch2)
-            update_sweep(c, sample_rate);
+        duty_counter += skip_clocks(c, n, sample_rate);
+    }
+    else
+    {
+        const uint64_t end = (uint64_t)n << 16;
+        const uint64_t period = ((uint64_t)sample_rate << 16) / c->freq_inc;
+        uint64_t t = blep_first_clock(c, sample_rate);
 
-        if (preferences_sound_mode == 2)
+        for (; t < end; t += period)
         {
-            uint32_t pos = 0;
-            uint32_t prev_pos = 0;
-            int32_t sample = 0;
-
-            while (update_freq(c, &pos, sample_rate))
-            {
-                c->square.duty_counter = (c->square.duty_counter + 1) & 7;
-                sample += ((pos - prev_pos) / c->freq_inc) * c->val;
-                c->val = (c->square.duty & (1 << c->square.duty_counter))
-                             ? VOL_INIT_MAX / MAX_CHAN_VOLUME
-                             : VOL_INIT_MIN / MAX_CHAN_VOLUME;
-                prev_pos = pos;
-            }
-
-            if (c->muted)
-                continue;
-
-            sample += c->val;
-            sample *= c->volume;
-            sample /= 4;
-
-            int32_t left_contrib = sample * c->on_left * audio->vol_l;
-            int32_t right_contrib = sample * c->on_right * audio->vol_r;
-
-            buffer[i] += (left_contrib + right_contrib) / 2;
+            duty_counter = (duty_counter + 1) & 7;
+            blep_set_level(c, accum, t, ((duty >> duty_counter) & 1) ? hi : lo);
         }
-        else
-        {
-            c->freq_counter += c->freq_inc;
-            while (c->freq_counter >= sample_rate)
-            {
-                c->freq_counter -= sample_rate;
-                c->square.duty_counter = (c->square.duty_counter + 1) & 7;
-                c->val = (c->square.duty & (1 << c->square.duty_counter))
-                             ? VOL_INIT_MAX / MAX_CHAN_VOLUME
-                             : VOL_INIT_MIN / MAX_CHAN_VOLUME;
-            }
-
-            if (c->muted)
-                continue;
-
-            int32_t sample = c->val;
-            sample *= c->volume;
-            sample >>= 2;
 
-            int32_t left_contrib = sample * c->on_left * audio->vol_l;
-            int32_t right_contrib = sample * c->on_right * audio->vol_r;
-
-            buffer[i] += (left_contrib + right_contrib) / 2;
-        }
+        blep_end_run(c, t, n, sample_rate);
     }
+
+    c->square.duty_counter = duty_counter & 7;
+    c->val = ((duty >> c->square.duty_counter) & 1) ? VOL_INIT_MAX / MAX_CHAN_VOLUME
+                                                     : VOL_INIT_MIN / MAX_CHAN_VOLUME;
 }
 
-__audio static int8_t wave_sample(
-    audio_data* audio, const unsigned int pos, const unsigned int volume
+// renders n samples at constant volume and frequency
+__audio static void square_run(
+    audio_data* restrict audio, struct chan* c, stereo_t* buffer, int n, int sample_rate
 )
 {
-    uint8_t sample;
+    const unsigned duty = c->square.duty;
+    unsigned duty_counter = c->square.duty_counter;
+
+    stereo_t hi = mix_level(c, (VOL_INIT_MAX / MAX_CHAN_VOLUME * c->volume) >> 2);
+    stereo_t lo = mix_level(c, (VOL_INIT_MIN / MAX_CHAN_VOLUME * c->volume) >> 2);
 
-    sample = audio_mem(audio)[(0xFF30 + pos / 2) - AUDIO_ADDR_COMPENSATION];
-    if (pos & 1)
+    if (c->muted || (hi == 0 && lo == 0))
     {
-        sample &= 0xF;
+        // silent; only the phase needs to advance
+        duty_counter += skip_clocks(c, n, sample_rate);
     }
     else
     {
-        sample >>= 4;
-    }
+        // each sample advances the duty cycle by q or q + 1 steps
+        const uint32_t q = c->freq_inc / sample_rate;
+        const uint32_t r = c->freq_inc % sample_rate;
+        uint32_t counter = c->freq_counter;
+
+        for (int i = 0; i < n; ++i)
+        {
+            counter += r;
+            uint32_t carry = counter >= (uint32_t)sample_rate;
+            counter -= carry * sample_rate;
+            duty_counter = (duty_counter + q + carry) & 7;
+            buffer[i] = stereo_add(buffer[i], ((duty >> duty_counter) & 1) ? hi : lo);
+        }
 
-    int8_t signed_sample = (int8_t)sample - 8;
+        c->freq_counter = counter;
+    }
 
-    return volume ? (signed_sample >> (volume - 1)) : 0;
+    c->square.duty_counter = duty_counter & 7;
+    c->val = ((duty >> c->square.duty_counter) & 1) ? VOL_INIT_MAX / MAX_CHAN_VOLUME
+                                                     : VOL_INIT_MIN / MAX_CHAN_VOLUME;
 }
 
-__audio static void update_wave(audio_data* restrict audio, int16_t* buffer, int len)
+// "accum" is non-NULL if rendering band-limited steps rather than directly
+// into "buffer".
+__audio static void update_square(
+    audio_data* restrict audio, stereo_t* buffer, struct blep_frame* accum, const bool ch2, int len
+)
 {
-    struct chan* chans = audio->chans;
-    struct chan* c = chans + 2;
+    struct chan* c = audio->chans + ch2;
 
     if (!c->powered || !c->enabled)
-        return;
+        goto silence;
 
-    uint32_t freq = (DMG_CLOCK_FREQ_U / 64) / (2048 - c->freq);
+    uint32_t freq = DMG_CLOCK_FREQ_U / ((2048 - c->freq) << 5);
     set_note_freq(c, freq);
-    c->freq_inc *= 32;
+    c->freq_inc *= 8;
 
-    if (preferences_sound_mode != 2)
-    {
-        if (c->freq_inc == 0)
-            return;
-    }
+    if (c->freq_inc == 0)
+        goto silence;
 
     len = update_len(audio, c, len);
     int sample_replication = get_sample_replication();
     int sample_rate = get_audio_sample_rate();
 
-    for (uint_fast16_t i = 0; i < len; i += sample_replication)
+    // envelope and sweep only tick at 64 Hz/128 Hz, so render in runs
+    // between their events.
+    for (int i = 0; i < len;)
     {
-        if (preferences_sound_mode == 2)
-        {
-            uint32_t pos = 0;
-            uint32_t prev_pos = 0;
-            int32_t sample = 0;
-
-            c->wave.sample = wave_sample(audio, c->val, c->volume);
-
-            while (update_freq(c, &pos, sample_rate))
-            {
-                c->val = (c->val + 1) & 31;
-                sample +=
-                    ((pos - prev_pos) / c->freq_inc) * (int32_t)c->wave.sample * (INT16_MAX / 32);
-                c->wave.sample = wave_sample(audio, c->val, c->volume);
-                prev_pos = pos;
-            }
-
-            sample += (int32_t)c->wave.sample * (int)(INT16_MAX / 32);
-
-            if (c->volume == 0 || c->muted)
-                continue;
-
-            sample /= 4;
+        update_env(c, sample_rate);
+        if (!ch2)
+            update_sweep(c, sample_rate);
 
-            int32_t left_contrib = sample * c->on_left * audio->vol_l;
-            int32_t right_contrib = sample * c->on_right * audio->vol_r;
+        int remaining = (len - i + sample_replication - 1) / sample_replication;
+        int run = begin_run(c, !ch2, remaining, sample_rate);
 
-            buffer[i] += (left_contrib + right_contrib) / 2;
+        if (accum)
+        {
+            square_run_blep(audio, c, accum + i / sample_replication, run, sample_rate);
         }
         else
         {
-            c->freq_counter += c->freq_inc;
-            while (c->freq_counter >= sample_rate)
-            {
-                c->freq_counter -= sample_rate;
-                c->val = (c->val + 1) & 31;
-            }
+            square_run(audio, c, buffer + i / sample_replication, run, sample_rate);
+        }
 
-            if (c->muted)
-                continue;
+        i += run * sample_replication;
+    }
 
-            int8_t wave_val = wave_sample(audio, c->val, c->volume);
-            int32_t sample = (int32_t)wave_val * (INT16_MAX / 32);
-            sample >>= 2;
+    // the length counter (or sweep) stopped the channel within this segment
+    if (c->enabled || !accum)
+        return;
 
-            int32_t left_contrib = sample * c->on_left * audio->vol_l;
-            int32_t right_contrib = sample * c->on_right * audio->vol_r;
+    blep_set_level(c, accum + len / sample_replication, 0, 0);
+    return;
 
-            buffer[i] += (left_contrib + right_contrib) / 2;
-        }
-    }
+silence:
+    if (accum)
+        blep_set_level(c, accum, 0, 0);
 }
 
-__audio static void update_noise(audio_data* restrict audio, int16_t* buffer, int len)
+// decodes wave RAM byte i into the wave table at the channel's volume
+static void wave_table_update(audio_data* restrict audio, const unsigned i)
 {
-    struct chan* c = audio->chans + 3;
+    const unsigned volume = audio->chans[2].volume;
+    const uint8_t byte = audio->regs[(0xFF30 + i) - AUDIO_ADDR_COMPENSATION];
+    const int8_t nibbles[2] = {(int8_t)(byte >> 4) - 8, (int8_t)(byte & 0xF) - 8};
 
-    if (!c->powered)
-        return;
+    for (unsigned j = 0; j < 2; ++j)
     {
-        uint32_t freq = precomputed_noise_freqs[c->noise.lfsr_div][c->freq];
-        set_note_freq(c, freq);
-
-        // A frequency of 0 would cause a division by zero in accurate sound
-        // mode.
-        if (c->freq_inc == 0)
-            return;
+        int32_t sample = volume ? (nibbles[j] >> (volume - 1)) : 0;
+        audio->wave_table[i * 2 + j] = (sample * (INT16_MAX / 32)) >> 2;
     }
+}
 
-    if (c->freq >= 14)
-        c->enabled = 0;
+static void wave_table_rebuild(audio_data* restrict audio)
+{
+    for (unsigned i = 0; i < 16; ++i)
+    {
+        wave_table_update(audio, i);
+    }
+}
 
-    len = update_len(audio, c, len);
+__audio static inline stereo_t wave_level(
+    audio_data* restrict audio, const struct chan* c, const unsigned pos
+)
+{
+    return mix_level(c, audio->wave_table[pos]);
+}
 
-    if (!c->enabled)
-        return;
+__audio static void wave_run_blep(
+    audio_data* restrict audio, struct chan* c, struct blep_frame* accum, int n, int sample_rate
+)
+{
+    unsigned pos = c->val;
 
-    int sample_replication = get_sample_replication();
-    int sample_rate = get_audio_sample_rate();
-    for (uint_fast16_t i = 0; i < len; i += sample_replication)
+    if (c->muted || c->volume == 0 || chan_silent(c))
     {
-        update_env(c, sample_rate);
+        blep_set_level(c, accum, 0, 0);
+        pos += skip_clocks(c, n, sample_rate);
+    }
+    else
+    {
+        const uint64_t end = (uint64_t)n << 16;
+        const uint64_t period = ((uint64_t)sample_rate << 16) / c->freq_inc;
+        uint64_t t = blep_first_clock(c, sample_rate);
+
+        blep_set_level(c, accum, 0, wave_level(audio, c, pos));
 
-        if (preferences_sound_mode == 2)
+        for (; t < end; t += period)
         {
-            uint32_t pos = 0;
-            uint32_t prev_pos = 0;
-            int32_t sample = 0;
+            pos = (pos + 1) & 31;
+            blep_set_level(c, accum, t, wave_level(audio, c, pos));
+        }
+
+        blep_end_run(c, t, n, sample_rate);
+    }
+
+    c->val = pos & 31;
+}
+
+__audio static void wave_run(
+    audio_data* restrict audio, struct chan* c, stereo_t* buffer, int n, int sample_rate
+)
+{
+    unsigned pos = c->val;
+
+    if (c->muted || c->volume == 0 || chan_silent(c))
+    {
+        // silent; only the position needs to advance
+        pos += skip_clocks(c, n, sample_rate);
+    }
+    else
+    {
+        const uint32_t q = c->freq_inc / sample_rate;
+        const uint32_t r = c->freq_inc % sample_rate;
+        uint32_t counter = c->freq_counter;
 
-            while (update_freq(c, &pos, sample_rate))
+        if (q == 0)
+        {
+            // each wave position lasts one or more samples; render it as a run
+            for (int i = 0; i < n;)
             {
-                c->noise.lfsr_reg =
-                    (c->noise.lfsr_reg << 1) | (c->val >= VOL_INIT_MAX / MAX_CHAN_VOLUME);
+                int hold = (sample_rate - counter + r - 1) / r - 1;
+                if (hold > n - i)
+                    hold = n - i;
 
-                if (c->lfsr_wide)
+                const stereo_t level = wave_level(audio, c, pos);
+                for (stereo_t* end = buffer + hold; buffer < end; ++buffer)
                 {
-                    c->val = !(((c->noise.lfsr_reg >> 14) & 1) ^ ((c->noise.lfsr_reg >> 13) & 1))
-                                 ? VOL_INIT_MAX / MAX_CHAN_VOLUME
-                                 : VOL_INIT_MIN / MAX_CHAN_VOLUME;
+                    *buffer = stereo_add(*buffer, level);
                 }
-                else
+
+                counter += hold * r;
+                i += hold;
+
+                if (i < n)
                 {
-                    c->val = !(((c->noise.lfsr_reg >> 6) & 1) ^ ((c->noise.lfsr_reg >> 5) & 1))
-                                 ? VOL_INIT_MAX / MAX_CHAN_VOLUME
-                                 : VOL_INIT_MIN / MAX_CHAN_VOLUME;
+                    counter += r - sample_rate;
+                    pos = (pos + 1) & 31;
+                    *buffer = stereo_add(*buffer, wave_level(audio, c, pos));
+                    ++buffer;
+                    ++i;
                 }
-                sample += ((pos - prev_pos) / c->freq_inc) * c->val;
-                prev_pos = pos;
             }
-
-            if (c->muted)
-                continue;
-
-            sample += c->val;
-            sample *= c->volume;
-            sample /= 4;
-
-            int32_t left_contrib = sample * c->on_left * audio->vol_l;
-            int32_t right_contrib = sample * c->on_right * audio->vol_r;
-
-            buffer[i] += (left_contrib + right_contrib) / 2;
         }
         else
         {
-            c->freq_counter += c->freq_inc;
-            while (c->freq_counter >= sample_rate)
+            for (int i = 0; i < n; ++i)
             {
-                c->freq_counter -= sample_rate;
-
-                uint16_t old_lfsr = c->noise.lfsr_reg;
-                c->noise.lfsr_reg <<= 1;
+                counter += r;
+                uint32_t carry = counter >= (uint32_t)sample_rate;
+                counter -= carry * sample_rate;
+                pos = (pos + q + carry) & 31;
 
-                uint8_t xor_res = (c->lfsr_wide) ? (((old_lfsr >> 14) & 1) ^ ((old_lfsr >> 13) & 1))
-                                                 : (((old_lfsr >> 6) & 1) ^ ((old_lfsr >> 5) & 1));
-
-                c->noise.lfsr_reg |= xor_res;
-                c->val = !xor_res ? VOL_INIT_MAX / MAX_CHAN_VOLUME : VOL_INIT_MIN / MAX_CHAN_VOLUME;
+                buffer[i] = stereo_add(buffer[i], wave_level(audio, c, pos));
             }
-
-            if (c->muted)
-                continue;
-
-            int32_t sample = c->val;
-            sample *= c->volume;
-            sample >>= 2;
-
-            int32_t left_contrib = sample * c->on_left * audio->vol_l;
-            int32_t right_contrib = sample * c->on_right * audio->vol_r;
-
-            buffer[i] += (left_contrib + right_contrib) / 2;
         }
+
+        c->freq_counter = counter;
     }
+
+    c->val = pos & 31;
 }
 
-static void chan_trigger(audio_data* restrict audio, uint_fast8_t i)
+__audio static void update_wave(
+    audio_data* restrict audio, stereo_t* buffer, struct blep_frame* accum, int len
+)
 {
     struct chan* chans = audio->chans;
-    struct chan* c = chans + i;
+    struct chan* c = chans + 2;
 
-    chan_enable(audio, i, 1);
+    if (!c->powered || !c->enabled)
+        goto silence;
+
+    uint32_t freq = (DMG_CLOCK_FREQ_U / 64) / (2048 - c->freq);
+    set_note_freq(c, freq);
+    c->freq_inc *= 32;
+
+    if (c->freq_inc == 0)
+        goto silence;
+
+    len = update_len(audio, c, len);
+    int sample_replication = get_sample_replication();
+    int sample_rate = get_audio_sample_rate();
+
+    // the wave channel has no envelope, so this is a single run
+    int n = (len + sample_replication - 1) / sample_replication;
+
+    if (accum)
+    {
+        wave_run_blep(audio, c, accum, n, sample_rate);
+    }
+    else
+    {
+        wave_run(audio, c, buffer, n, sample_rate);
+    }
+
+    if (c->enabled || !accum)
+        return;
+
+    blep_set_level(c, accum + n, 0, 0);
+    return;
+
+silence:
+    if (accum)
+        blep_set_level(c, accum, 0, 0);
+}
+
+static void lfsr_seq_build(uint32_t* seq, const unsigned words, const unsigned tap)
+{
+    uint16_t lfsr = 0xFFFF;
+
+    memset(seq, 0, words * sizeof(uint32_t));
+    seq[0] = 1;
+
+    for (unsigned pos = 1; pos < words * 32; ++pos)
+    {
+        unsigned bit = ((lfsr >> tap) ^ (lfsr >> (tap - 1))) & 1;
+        lfsr = (lfsr << 1) | bit;
+        seq[pos / 32] |= bit << (pos % 32);
+    }
+}
+
+__audio static inline unsigned lfsr_bit(const uint32_t* seq, const unsigned pos)
+{
+    return (seq[pos / 32] >> (pos % 32)) & 1;
+}
+
+// number of set bits in positions [pos, pos + len) of the sequence
+__audio static unsigned lfsr_ones(const uint32_t* seq, unsigned pos, unsigned len)
+{
+    unsigned ones = 0;
+
+    while (len > 0)
+    {
+        unsigned span = len > 32 ? 32 : len;
+        uint64_t window = seq[pos / 32] | ((uint64_t)seq[pos / 32 + 1] << 32);
+        uint32_t bits = (uint32_t)(window >> (pos % 32));
+
+        if (span < 32)
+            bits &= (1u << span) - 1;
+
+        ones += __builtin_popcount(bits);
+        pos += span;
+        len -= span;
+    }
+
+    return ones;
+}
+
+__audio static inline const uint32_t* noise_seq(const struct chan* c, unsigned* period)
+{
+    *period = c->lfsr_wide ? LFSR15_PERIOD : LFSR7_PERIOD;
+    return c->lfsr_wide ? lfsr15_seq : lfsr7_seq;
+}
+
+__audio static inline int_fast16_t noise_val(const uint32_t* seq, const unsigned pos)
+{
+    return lfsr_bit(seq, pos) ? VOL_INIT_MIN / MAX_CHAN_VOLUME : VOL_INIT_MAX / MAX_CHAN_VOLUME;
+}
+
+__audio static void noise_run_blep(
+    audio_data* restrict audio, struct chan* c, struct blep_frame* accum, int n, int sample_rate
+)
+{
+    unsigned period;
+    const uint32_t* seq = noise_seq(c, &period);
+    unsigned pos = c->noise.lfsr_pos;
+
+    stereo_t hi = 0;
+    stereo_t lo = 0;
+    if (!c->muted)
+    {
+        hi = mix_level(c, (VOL_INIT_MAX / MAX_CHAN_VOLUME * c->volume) >> 2);
+        lo = mix_level(c, (VOL_INIT_MIN / MAX_CHAN_VOLUME * c->volume) >> 2);
+    }
+
+    blep_set_level(c, accum, 0, lfsr_bit(seq, pos) ? lo : hi);
+
+    if (hi == lo)
+    {
+        pos = (pos + skip_clocks(c, n, sample_rate)) % period;
+    }
+    else if (c->freq_inc >= (uint32_t)sample_rate)
+    {
+        // at least one clock per sample, so edges are too dense to place
+        // individually; step to the average level over each sample instead.
+        const uint32_t q = c->freq_inc / sample_rate;
+        const uint32_t r = c->freq_inc % sample_rate;
+        uint32_t counter = c->freq_counter;
+
+        for (int i = 0; i < n; ++i)
+        {
+            counter += r;
+            uint32_t carry = counter >= (uint32_t)sample_rate;
+            counter -= carry * sample_rate;
+
+            int32_t clocks = q + carry;
+            int32_t ones = lfsr_ones(seq, pos + 1, clocks);
+            pos += clocks;
+            if (pos >= period)
+                pos -= period;
+
+            int32_t left = stereo_left(hi) * (clocks - ones) + stereo_left(lo) * ones;
+            int32_t right = stereo_right(hi) * (clocks - ones) + stereo_right(lo) * ones;
+            blep_set_level(c, accum, i << 16, stereo_pack(left / clocks, right / clocks));
+        }
+
+        c->freq_counter = counter;
+    }
+    else
+    {
+        const uint64_t end = (uint64_t)n << 16;
+        const uint64_t clock_period = ((uint64_t)sample_rate << 16) / c->freq_inc;
+        uint64_t t = blep_first_clock(c, sample_rate);
+
+        for (; t < end; t += clock_period)
+        {
+            if (++pos == period)
+                pos = 0;
+            blep_set_level(c, accum, t, lfsr_bit(seq, pos) ? lo : hi);
+        }
+
+        blep_end_run(c, t, n, sample_rate);
+    }
+
+    c->noise.lfsr_pos = pos;
+    c->val = noise_val(seq, pos);
+}
+
+__audio static void noise_run(
+    audio_data* restrict audio, struct chan* c, stereo_t* buffer, int n, int sample_rate
+)
+{
+    unsigned period;
+    const uint32_t* seq = noise_seq(c, &period);
+    unsigned pos = c->noise.lfsr_pos;
+
+    stereo_t hi = mix_level(c, (VOL_INIT_MAX / MAX_CHAN_VOLUME * c->volume) >> 2);
+    stereo_t lo = mix_level(c, (VOL_INIT_MIN / MAX_CHAN_VOLUME * c->volume) >> 2);
+
+    if (c->muted || (hi == 0 && lo == 0))
+    {
+        // silent; only the position needs to advance
+        pos = (pos + skip_clocks(c, n, sample_rate)) % period;
+    }
+    else
+    {
+        const uint32_t q = c->freq_inc / sample_rate;
+        const uint32_t r = c->freq_inc % sample_rate;
+        uint32_t counter = c->freq_counter;
+
+        for (int i = 0; i < n; ++i)
+        {
+            counter += r;
+            uint32_t carry = counter >= (uint32_t)sample_rate;
+            counter -= carry * sample_rate;
+
+            pos += q + carry;
+            if (pos >= period)
+                pos -= period;
+
+            buffer[i] = stereo_add(buffer[i], lfsr_bit(seq, pos) ? lo : hi);
+        }
+
+        c->freq_counter = counter;
+    }
+
+    c->noise.lfsr_pos = pos;
+    c->val = noise_val(seq, pos);
+}
+
+__audio static void update_noise(
+    audio_data* restrict audio, stereo_t* buffer, struct blep_frame* accum, int len
+)
+{
+    struct chan* c = audio->chans + 3;
+
+    if (!c->powered)
+        goto silence;
+    {
+        uint32_t freq = precomputed_noise_freqs[c->noise.lfsr_div][c->freq];
+        set_note_freq(c, freq);
+
+        // A frequency of 0 would cause a division by zero in accurate sound
+        // mode.
+        if (c->freq_inc == 0)
+            goto silence;
+    }
+
+    if (c->freq >= 14)
+        c->enabled = 0;
+
+    len = update_len(audio, c, len);
+
+    if (!c->enabled)
+        goto silence;
+
+    int sample_replication = get_sample_replication();
+    int sample_rate = get_audio_sample_rate();
+    for (int i = 0; i < len;)
+    {
+        update_env(c, sample_rate);
+
+        int remaining = (len - i + sample_replication - 1) / sample_replication;
+        int run = begin_run(c, false, remaining, sample_rate);
+
+        if (accum)
+        {
+            noise_run_blep(audio, c, accum + i / sample_replication, run, sample_rate);
+        }
+        else
+        {
+            noise_run(audio, c, buffer + i / sample_replication, run, sample_rate);
+        }
+
+        i += run * sample_replication;
+    }
+
+    if (c->enabled || !accum)
+        return;
+
+    blep_set_level(c, accum + len / sample_replication, 0, 0);
+    return;
+
+silence:
+    if (accum)
+        blep_set_level(c, accum, 0, 0);
+}
+
+static void chan_trigger(audio_data* restrict audio, uint_fast8_t i)
+{
+    struct chan* chans = audio->chans;
+    struct chan* c = chans + i;
+
+    chan_enable(audio, i, 1);
     c->volume = c->volume_init;
 
     // volume envelope
     {
-        uint8_t val = audio_mem(audio)[(0xFF12 + (i * 5)) - AUDIO_ADDR_COMPENSATION];
+        uint8_t val = audio->regs[(0xFF12 + (i * 5)) - AUDIO_ADDR_COMPENSATION];
 
         c->env.step = val & 0x07;
         c->env.up = val & 0x08 ? 1 : 0;
@@ -483,7 +1117,7 @@ static void chan_trigger(audio_data* restrict audio, uint_fast8_t i)
     // freq sweep
     if (i == 0)
     {
-        uint8_t val = audio_mem(audio)[0xFF10 - AUDIO_ADDR_COMPENSATION];
+        uint8_t val = audio->regs[0xFF10 - AUDIO_ADDR_COMPENSATION];
 
         c->sweep.freq = c->freq;
         c->sweep.rate = (val >> 4) & 0x07;
@@ -502,7 +1136,7 @@ static void chan_trigger(audio_data* restrict audio, uint_fast8_t i)
     }
     else if (i == 3)
     {  // noise
-        c->noise.lfsr_reg = 0xFFFF;
+        c->noise.lfsr_pos = 0;
         c->val = VOL_INIT_MIN / MAX_CHAN_VOLUME;
     }
 
@@ -531,16 +1165,33 @@ uint8_t audio_read(audio_data* audio, const uint16_t addr)
     };
     /* clang-format on */
 
+    if (addr == 0xFF26)
+    {
+        // channel status is maintained by the audio callback
+        return (audio_mem(audio)[addr - AUDIO_ADDR_COMPENSATION] & 0x80) |
+               ortab[addr - AUDIO_ADDR_COMPENSATION] |
+               __atomic_load_n(&audio_queue.status, __ATOMIC_RELAXED);
+    }
+
     return audio_mem(audio)[addr - AUDIO_ADDR_COMPENSATION] | ortab[addr - AUDIO_ADDR_COMPENSATION];
 }
 
+// refreshes each channel's per-side gain after a write to NR50 or NR51
+static void chan_update_gains(audio_data* restrict audio)
+{
+    for (uint_fast8_t i = 0; i < 4; i++)
+    {
+        struct chan* c = audio->chans + i;
+        c->gain_left = c->on_left * audio->vol_l;
+        c->gain_right = c->on_right * audio->vol_r;
+    }
+}
+
 /**
- * Write audio register.
- * \param addr  Address of audio register. Must be 0xFF10 <= addr <= 0xFF3F.
- *              This is not checked in this function.
- * \param val   Byte to write at address.
+ * Apply a register write to the synthesiser. Only the consumer (audio
+ * callback) may call this once the audio queue is running.
  */
-void audio_write(audio_data* restrict audio, const uint16_t addr, const uint8_t val)
+static void audio_apply_write(audio_data* restrict audio, const uint16_t addr, const uint8_t val)
 {
     /* Find sound channel corresponding to register address. */
     uint_fast8_t i;
@@ -548,24 +1199,31 @@ void audio_write(audio_data* restrict audio, const uint16_t addr, const uint8_t
 
     if (addr == 0xFF26)
     {
-        audio_mem(audio)[addr - AUDIO_ADDR_COMPENSATION] = val & 0x80;
+        audio->regs[addr - AUDIO_ADDR_COMPENSATION] = val & 0x80;
         /* On APU power off, clear all registers apart from wave RAM. */
         if ((val & 0x80) == 0)
         {
-            memset(audio_mem(audio), 0x00, 0xFF26 - AUDIO_ADDR_COMPENSATION);
+            memset(audio->regs, 0x00, 0xFF26 - AUDIO_ADDR_COMPENSATION);
             chans[0].enabled = false;
             chans[1].enabled = false;
             chans[2].enabled = false;
             chans[3].enabled = false;
         }
+        chan_enable(audio, 0, chans[0].enabled);
         return;
     }
 
     /* Ignore register writes if APU powered off. */
-    if (audio_mem(audio)[0xFF26 - AUDIO_ADDR_COMPENSATION] == 0x00)
+    if (audio->regs[0xFF26 - AUDIO_ADDR_COMPENSATION] == 0x00)
         return;
 
-    audio_mem(audio)[addr - AUDIO_ADDR_COMPENSATION] = val;
+    audio->regs[addr - AUDIO_ADDR_COMPENSATION] = val;
+
+    if (addr >= 0xFF30)
+    {
+        wave_table_update(audio, addr - 0xFF30);
+        return;
+    }
 
     if (preferences_sound_mode == 2)
     {
@@ -612,6 +1270,7 @@ void audio_write(audio_data* restrict audio, const uint16_t addr, const uint8_t
 
     case 0xFF1C:
         chans[i].volume = chans[i].volume_init = (val >> 5) & 0x03;
+        wave_table_rebuild(audio);
         break;
 
     case 0xFF11:
@@ -658,12 +1317,17 @@ void audio_write(audio_data* restrict audio, const uint16_t addr, const uint8_t
     case 0xFF22:
         chans[3].freq = val >> 4;
         chans[3].lfsr_wide = !(val & 0x08);
+        if (!chans[3].lfsr_wide)
+        {
+            chans[3].noise.lfsr_pos %= LFSR7_PERIOD;
+        }
         chans[3].noise.lfsr_div = val & 0x07;
         break;
 
     case 0xFF24:
         audio->vol_l = ((val >> 4) & 0x07);
         audio->vol_r = (val & 0x07);
+        chan_update_gains(audio);
         break;
 
     case 0xFF25:
@@ -672,16 +1336,59 @@ void audio_write(audio_data* restrict audio, const uint16_t addr, const uint8_t
             chans[j].on_left = (val >> (4 + j)) & 1;
             chans[j].on_right = (val >> j) & 1;
         }
+        chan_update_gains(audio);
         break;
     }
 }
 
+// discards the writes in flight: the consumer skips up to the current head
+// the next time it looks at the queue (see audio_queue_tail). Producer only.
+static void audio_queue_reset(void)
+{
+    __atomic_store_n(&audio_queue.reset_head, audio_queue.head, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&audio_queue.reset_epoch, 1, __ATOMIC_RELEASE);
+}
+
+// the producer's view of the consumer's position, past any writes discarded
+// by a reset that the consumer hasn't skipped yet
+static uint32_t audio_queue_producer_tail(void)
+{
+    uint32_t tail = __atomic_load_n(&audio_queue.tail, __ATOMIC_ACQUIRE);
+    return (int32_t)(audio_queue.reset_head - tail) > 0 ? audio_queue.reset_head : tail;
+}
+
 void audio_init(audio_data* audio)
 {
     struct chan* chans = audio->chans;
 
+    audio_hold();
+
+    /* Discard any writes still in flight. */
+    audio_queue_reset();
+    audio_queue.synced = false;
+    audio_queue.audio = audio;
+    audio_queue.cycles_per_sample = AUDIO_CYCLES_PER_SAMPLE;
+    audio_queue.rate_adjust = 0;
+    audio_queue.main_thread = preferences_sound_render != 0;
+    audio_queue.underruns = 0;
+    audio_queue.overruns = 0;
+    audio_queue.overflows = 0;
+    audio_queue.dropped[0] = audio_queue.dropped[1] = 0;
+    audio_queue.dropped_triggers = 0;
+
+    memset(blep_accum, 0, sizeof(blep_accum));
+    memset(&blep_sum, 0, sizeof(blep_sum));
+    mix_mono = false;
+    upsample_prev = 0;
+
+    audio_ring.head = audio_ring.tail = 0;
+    audio_ring.frac = 0;
+    audio_ring.prev = audio_ring.next = 0;
+    audio_ring.priming = true;
+
     /* Initialise channels and samples. */
     memset(chans, 0, 4 * sizeof(struct chan));
+    audio->audio_mem = audio_mem(audio);
     chans[0].val = chans[1].val = -1;
 
     /* Initialise IO registers. */
@@ -696,7 +1403,7 @@ void audio_init(audio_data* audio)
         /* clang-format on */
 
         for (uint_fast8_t i = 0; i < sizeof(regs_init); ++i)
-            audio_write(audio, 0xFF10 + i, regs_init[i]);
+            audio_apply_write(audio, 0xFF10 + i, regs_init[i]);
     }
 
     /* Initialise Wave Pattern RAM. */
@@ -710,9 +1417,12 @@ void audio_init(audio_data* audio)
         /* clang-format on */
 
         for (uint_fast8_t i = 0; i < sizeof(wave_init); ++i)
-            audio_write(audio, 0xFF30 + i, wave_init[i]);
+            audio_apply_write(audio, 0xFF30 + i, wave_init[i]);
     }
 
+    lfsr_seq_build(lfsr15_seq, LFSR_SEQ_WORDS(LFSR15_PERIOD), 14);
+    lfsr_seq_build(lfsr7_seq, LFSR_SEQ_WORDS(LFSR7_PERIOD), 6);
+
     for (uint8_t lfsr_selector_idx = 0; lfsr_selector_idx < 8; ++lfsr_selector_idx)
     {
         uint32_t current_lfsr_div_val = lfsr_selector_idx == 0 ? 8 : lfsr_selector_idx * 16;
@@ -733,72 +1443,902 @@ void audio_init(audio_data* audio)
             }
         }
     }
+
+    /* The CPU sees the same initial register values. */
+    memcpy(audio_mem(audio), audio->regs, AUDIO_MEM_SIZE);
+    audio_mem(audio)[0xFF26 - AUDIO_ADDR_COMPENSATION] &= 0x80;
+
+    audio_release();
 }
 
-int audio_enabled;
+void audio_init_from_regs(audio_data* audio)
+{
+    uint8_t regs[AUDIO_MEM_SIZE];
+    memcpy(regs, audio_mem(audio), AUDIO_MEM_SIZE);
+
+    audio_init(audio);
+
+    audio_hold();
+
+    /* Give the CPU its registers back, and replay them into the synthesiser:
+     * NR52 first, as the others are ignored while the APU is off. Which
+     * channels were playing isn't known, so none is retriggered. */
+    memcpy(audio_mem(audio), regs, AUDIO_MEM_SIZE);
+    audio_apply_write(audio, 0xFF26, regs[0xFF26 - AUDIO_ADDR_COMPENSATION]);
+
+    for (uint16_t addr = 0xFF10; addr < 0xFF26; ++addr)
+    {
+        uint8_t val = regs[addr - AUDIO_ADDR_COMPENSATION];
+        if ((addr - AUDIO_ADDR_COMPENSATION) % 5 == 4)
+            val &= 0x7F;
+        audio_apply_write(audio, addr, val);
+    }
+
+    /* Wave RAM keeps its contents even while the APU is off. */
+    memcpy(audio->regs + 0x20, regs + 0x20, 0x10);
+    wave_table_rebuild(audio);
+
+    audio_release();
+}
 
 /**
- * Playdate audio callback function.
+ * Write audio register.
+ * \param addr  Address of audio register. Must be 0xFF10 <= addr <= 0xFF3F.
+ *              This is not checked in this function.
+ * \param val   Byte to write at address.
+ * \param cycle CPU cycle timestamp of the write.
  */
-__audio int audio_callback(void* context, int16_t* left, int16_t* right, int len)
+void audio_write(
+    audio_data* restrict audio, const uint16_t addr, const uint8_t val, const uint32_t cycle
+)
 {
-    if (!audio_enabled)
-        return 0;
+    uint8_t* mem = audio_mem(audio);
 
-    DTCM_VERIFY_DEBUG();
+    /* Update the CPU's view immediately, so that reads are consistent. */
+    if (addr == 0xFF26)
+    {
+        mem[addr - AUDIO_ADDR_COMPENSATION] = val & 0x80;
+        if ((val & 0x80) == 0)
+        {
+            memset(mem, 0x00, 0xFF26 - AUDIO_ADDR_COMPENSATION);
+        }
+    }
+    else
+    {
+        /* Ignore register writes if APU powered off. */
+        if (mem[0xFF26 - AUDIO_ADDR_COMPENSATION] == 0x00)
+            return;
 
-    CB_GameScene** gameScene_ptr = context;
-    CB_GameScene* gameScene = *gameScene_ptr;
+        mem[addr - AUDIO_ADDR_COMPENSATION] = val;
+    }
 
-    if (!gameScene || gameScene->audioLocked)
+    uint32_t head = audio_queue.head;
+    if (head - audio_queue_producer_tail() >= AUDIO_QUEUE_SIZE ||
+        __atomic_load_n(&audio_queue.dropped[0], __ATOMIC_ACQUIRE) ||
+        __atomic_load_n(&audio_queue.dropped[1], __ATOMIC_ACQUIRE))
     {
-        return 0;
+        unsigned reg = addr - 0xFF10;
+        audio_queue.overflows++;
+        if ((val & 0x80) && reg % 5 == 4 && reg < 20)
+        {
+            __atomic_fetch_or(&audio_queue.dropped_triggers, 1u << (reg / 5), __ATOMIC_RELAXED);
+        }
+        __atomic_fetch_or(&audio_queue.dropped[reg / 32], 1u << (reg % 32), __ATOMIC_RELEASE);
+        return;
     }
 
-#ifdef TARGET_SIMULATOR
-    pthread_mutex_lock(&audio_mutex);
-#endif
+    struct audio_write_entry* entry = &audio_queue.entries[head & (AUDIO_QUEUE_SIZE - 1)];
+    entry->cycle = cycle;
+    entry->addr = addr;
+    entry->val = val;
+    __atomic_store_n(&audio_queue.head, head + 1, __ATOMIC_RELEASE);
+}
 
-    audio_data* audio = &gameScene->context->gb->audio;
+int audio_enabled;
 
-    __builtin_prefetch(left, 1);
+// offset (in output samples) of the given timestamp from the consumer's clock
+__audio static int audio_queue_sample_index(const uint32_t cycle)
+{
+    int32_t delta = (int32_t)(cycle - audio_queue.cycle);
+    if (delta <= 0)
+        return 0;
 
-    int sample_replication = get_sample_replication();
-    int max_chunk = ((256 + sample_replication - 1) / sample_replication) * sample_replication;
+    int64_t t = ((int64_t)delta << 16) - audio_queue.cycle_frac;
+    return (int)(t / audio_queue.cycles_per_sample);
+}
 
-    while (len > 0)
-    {
-        int chunksize = len >= max_chunk ? max_chunk : len;
+// rate adjustment (16.16 CPU cycles per sample) for the given latency error
+// (CPU cycles)
+__audio static int32_t audio_rate_adjust(int32_t error)
+{
+    const int32_t range = AUDIO_CYCLES_PER_SAMPLE / AUDIO_RATE_RANGE;
+    int32_t adjust = (int32_t)((int64_t)range * error / (int32_t)SCREEN_REFRESH_CYCLES);
+    return adjust > range ? range : adjust < -range ? -range : adjust;
+}
+
+// Once the queue has been consumed up to tail, applies the writes which
+// didn't fit in it, with the registers' latest values as the CPU sees them.
+// (A write made meanwhile may be applied twice, which is harmless.)
+__audio static void audio_queue_reload(audio_data* restrict audio, uint32_t tail)
+{
+    if (!__atomic_load_n(&audio_queue.dropped[0], __ATOMIC_ACQUIRE) &&
+        !__atomic_load_n(&audio_queue.dropped[1], __ATOMIC_ACQUIRE))
+        return;
+
+    // no write is queued while any is dropped, so this is final
+    if (tail != __atomic_load_n(&audio_queue.head, __ATOMIC_ACQUIRE))
+        return;
 
-        memset(left, 0, chunksize * sizeof(int16_t));
+    uint32_t dropped[2] = {
+        __atomic_exchange_n(&audio_queue.dropped[0], 0, __ATOMIC_ACQ_REL),
+        __atomic_exchange_n(&audio_queue.dropped[1], 0, __ATOMIC_ACQ_REL),
+    };
+    uint32_t triggers = __atomic_exchange_n(&audio_queue.dropped_triggers, 0, __ATOMIC_ACQ_REL);
+    const uint8_t* mem = audio_mem(audio);
 
-        update_wave(audio, left, chunksize);
-        update_square(audio, left, 0, chunksize);
-        update_square(audio, left, 1, chunksize);
-        update_noise(audio, left, chunksize);
+    // NR52 first, as the others are ignored while the APU is off
+    const unsigned nr52 = 0xFF26 - 0xFF10;
+    if (dropped[nr52 / 32] & (1u << (nr52 % 32)))
+    {
+        audio_apply_write(audio, 0xFF26, mem[0xFF26 - AUDIO_ADDR_COMPENSATION]);
+        dropped[nr52 / 32] &= ~(1u << (nr52 % 32));
+    }
 
-        // 3. Handle sample replication on the 'left' buffer.
-        if (sample_replication > 1)
+    for (unsigned reg = 0; reg < AUDIO_MEM_SIZE; ++reg)
+    {
+        if (dropped[reg / 32] & (1u << (reg % 32)))
         {
-            for (int i = 0; i < chunksize; i += sample_replication)
+            uint16_t addr = 0xFF10 + reg;
+            uint8_t val = mem[addr - AUDIO_ADDR_COMPENSATION];
+            if (reg % 5 == 4 && reg < 20 && (triggers & (1u << (reg / 5))))
             {
-                for (int j = 1; j < sample_replication && (i + j) < chunksize; ++j)
-                {
-                    left[i + j] = left[i];
-                }
+                val |= 0x80;
             }
+            audio_apply_write(audio, addr, val);
         }
+    }
+}
 
-        len -= chunksize;
-        left += chunksize;
-        right += chunksize;
+// the consumer's position in the queue, first skipping the writes that the
+// producer discarded by resetting it; a reset also resyncs the consumer.
+__audio static uint32_t audio_queue_tail(void)
+{
+    uint32_t epoch = __atomic_load_n(&audio_queue.reset_epoch, __ATOMIC_ACQUIRE);
+    if (epoch == audio_queue.reset_seen)
+        return audio_queue.tail;
+
+    // writes queued since the reset may already have been consumed
+    uint32_t reset_head = __atomic_load_n(&audio_queue.reset_head, __ATOMIC_RELAXED);
+    if ((int32_t)(reset_head - audio_queue.tail) > 0)
+    {
+        __atomic_store_n(&audio_queue.tail, reset_head, __ATOMIC_RELEASE);
     }
 
-#ifdef TARGET_SIMULATOR
-    pthread_mutex_unlock(&audio_mutex);
-#endif
+    audio_queue.reset_seen = epoch;
+    audio_queue.synced = false;
+    return audio_queue.tail;
+}
 
-    DTCM_VERIFY_DEBUG();
+// apply all pending writes without rendering anything
+__audio static void audio_queue_drain(audio_data* restrict audio)
+{
+    uint32_t tail = audio_queue_tail();
+    uint32_t head = __atomic_load_n(&audio_queue.head, __ATOMIC_ACQUIRE);
 
-    return 1;
+    while (tail != head)
+    {
+        const struct audio_write_entry* entry = &audio_queue.entries[tail & (AUDIO_QUEUE_SIZE - 1)];
+        audio_apply_write(audio, entry->addr, entry->val);
+        ++tail;
+    }
+
+    __atomic_store_n(&audio_queue.tail, tail, __ATOMIC_RELEASE);
+    audio_queue_reload(audio, tail);
+    audio_queue.synced = false;
+}
+
+// renders len output samples, either directly into buffer (at the internal
+// sample rate), or (if accum is non-NULL) as band-limited steps into accum.
+__audio static void audio_render(
+    audio_data* restrict audio, stereo_t* buffer, struct blep_frame* accum, int len
+)
+{
+    if (len <= 0)
+        return;
+
+    update_wave(audio, buffer, accum, len);
+    update_square(audio, buffer, accum, 0, len);
+    update_square(audio, buffer, accum, 1, len);
+    update_noise(audio, buffer, accum, len);
+}
+
+// converts the first n internal samples' worth of accumulated steps into
+// samples in audio_mix.
+__audio static void blep_integrate(int n)
+{
+    struct blep_frame sum = blep_sum;
+
+    if (mix_mono)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            sum.left += blep_accum[i].left;
+
+            int32_t sample = clamp16(sum.left >> BLEP_SCALE_BITS);
+            audio_mix[i] = stereo_pack(sample, sample);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            sum.left += blep_accum[i].left;
+            sum.right += blep_accum[i].right;
+
+            int32_t sample_left = clamp16(sum.left >> BLEP_SCALE_BITS);
+            int32_t sample_right = clamp16(sum.right >> BLEP_SCALE_BITS);
+            audio_mix[i] = stereo_pack(sample_left, sample_right);
+        }
+    }
+
+    blep_sum = sum;
+
+    // carry the kernels' tails over to the next chunk
+    memmove(blep_accum, blep_accum + n, BLEP_TAPS * sizeof(struct blep_frame));
+    memset(blep_accum + BLEP_TAPS, 0, n * sizeof(struct blep_frame));
+}
+
+// splits the first len output samples' worth of the mix into the left and
+// right output buffers, upsampling it to the output rate: each internal
+// sample is ramped to linearly from the previous one, rather than repeated.
+__audio static void mix_output(int16_t* left, int16_t* right, int len, int step)
+{
+    const int n = (len + step - 1) / step;
+    stereo_t prev = upsample_prev;
+
+    if (step == 1 && mix_mono)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            left[i] = stereo_left(audio_mix[i]);
+        }
+        memcpy(right, left, n * sizeof(int16_t));
+        upsample_prev = n > 0 ? audio_mix[n - 1] : prev;
+        return;
+    }
+
+    if (step == 1)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            left[i] = stereo_left(audio_mix[i]);
+            right[i] = stereo_right(audio_mix[i]);
+        }
+        upsample_prev = n > 0 ? audio_mix[n - 1] : prev;
+        return;
+    }
+
+    // at 22.05 and 11.025 kHz, the points between are found by halving,
+    // both sides at once
+    const int whole = len / step;
+    int i = 0;
+
+    if (step == 2)
+    {
+        for (; i < whole; ++i, left += 2, right += 2)
+        {
+            const stereo_t sample = audio_mix[i];
+            const stereo_t mid = stereo_halve_sum(prev, sample);
+            left[0] = stereo_left(mid);
+            right[0] = stereo_right(mid);
+            left[1] = stereo_left(sample);
+            right[1] = stereo_right(sample);
+            prev = sample;
+        }
+    }
+    else if (step == 4)
+    {
+        for (; i < whole; ++i, left += 4, right += 4)
+        {
+            const stereo_t sample = audio_mix[i];
+            const stereo_t mid = stereo_halve_sum(prev, sample);
+            const stereo_t first = stereo_halve_sum(prev, mid);
+            const stereo_t third = stereo_halve_sum(mid, sample);
+            left[0] = stereo_left(first);
+            right[0] = stereo_right(first);
+            left[1] = stereo_left(mid);
+            right[1] = stereo_right(mid);
+            left[2] = stereo_left(third);
+            right[2] = stereo_right(third);
+            left[3] = stereo_left(sample);
+            right[3] = stereo_right(sample);
+            prev = sample;
+        }
+    }
+
+    // otherwise (and for a partial last sample), in 0.15 fixed point; the
+    // deltas span at most 17 bits, so this can't overflow. The ramp is
+    // accumulated rather than multiplied out per output sample.
+    const int32_t inc = (1 << 15) / step;
+
+    for (; i < n; ++i, left += step, right += step)
+    {
+        const stereo_t sample = audio_mix[i];
+        const int32_t step_left = (stereo_left(sample) - stereo_left(prev)) * inc;
+        const int32_t step_right = (stereo_right(sample) - stereo_right(prev)) * inc;
+        int32_t acc_left = stereo_left(prev) * (1 << 15) + (1 << 14);
+        int32_t acc_right = stereo_right(prev) * (1 << 15) + (1 << 14);
+
+        const int m = len - i * step < step ? len - i * step : step;
+        for (int j = 0; j < m; ++j)
+        {
+            acc_left += step_left;
+            acc_right += step_right;
+            left[j] = acc_left >> 15;
+            right[j] = acc_right >> 15;
+        }
+
+        prev = sample;
+    }
+
+    upsample_prev = prev;
+}
+
+// true if every channel is panned to the centre. With band-limited steps
+// (accum non-NULL), their levels and the steps still carried over must also
+// be the same on both sides, so that a mono mix plays exactly the same.
+__audio static bool mix_centred(const audio_data* restrict audio, const struct blep_frame* accum)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        const struct chan* c = audio->chans + i;
+        if (c->gain_left != c->gain_right)
+            return false;
+        if (accum && stereo_left(c->blep_level) != stereo_right(c->blep_level))
+            return false;
+    }
+
+    if (!accum)
+        return true;
+
+    if (blep_sum.left != blep_sum.right)
+        return false;
+
+    for (int k = 0; k < BLEP_TAPS; ++k)
+    {
+        if (accum[k].left != accum[k].right)
+            return false;
+    }
+
+    return true;
+}
+
+// switches the mix back to stereo once a channel is no longer centred; the
+// mono mix kept the band-limited steps in their left half only.
+__audio static void mix_leave_mono(audio_data* restrict audio)
+{
+    if (!mix_mono || mix_centred(audio, NULL))
+        return;
+
+    for (int k = 0; k < AUDIO_MAX_CHUNK + BLEP_TAPS; ++k)
+    {
+        blep_accum[k].right = blep_accum[k].left;
+    }
+    blep_sum.right = blep_sum.left;
+    mix_mono = false;
+}
+
+// renders the next chunksize output samples' worth into audio_mix (at the
+// internal sample rate), applying the queued writes as their timestamps are
+// reached, and advances the consumer's clock past them.
+__audio static void audio_render_chunk(
+    audio_data* restrict audio, int chunksize, int sample_replication
+)
+{
+    struct blep_frame* accum = (preferences_sound_mode == 2) ? blep_accum : NULL;
+    int n = (chunksize + sample_replication - 1) / sample_replication;
+
+    if (!accum)
+    {
+        memset(audio_mix, 0, n * sizeof(stereo_t));
+    }
+
+    // the mix only turns mono at the start of a chunk, so that a mono
+    // chunk is mono throughout
+    if (mix_mono)
+    {
+        mix_leave_mono(audio);
+    }
+    else
+    {
+        mix_mono = mix_centred(audio, accum);
+    }
+
+    // render up to each queued write, then apply it
+    uint32_t tail = audio_queue_tail();
+    uint32_t head = __atomic_load_n(&audio_queue.head, __ATOMIC_ACQUIRE);
+    int pos = 0;
+
+    while (tail != head)
+    {
+        const struct audio_write_entry* entry = &audio_queue.entries[tail & (AUDIO_QUEUE_SIZE - 1)];
+
+        int at = audio_queue_sample_index(entry->cycle);
+        if (at >= chunksize)
+            break;
+
+        // segments must stay aligned to the replication step
+        at -= at % sample_replication;
+        if (at > pos)
+        {
+            audio_render(
+                audio, audio_mix + pos / sample_replication,
+                accum ? accum + pos / sample_replication : NULL, at - pos
+            );
+            pos = at;
+        }
+
+        audio_apply_write(audio, entry->addr, entry->val);
+        mix_leave_mono(audio);
+        ++tail;
+    }
+
+    __atomic_store_n(&audio_queue.tail, tail, __ATOMIC_RELEASE);
+    audio_queue_reload(audio, tail);
+    mix_leave_mono(audio);
+
+    audio_render(
+        audio, audio_mix + pos / sample_replication,
+        accum ? accum + pos / sample_replication : NULL, chunksize - pos
+    );
+
+    if (accum)
+    {
+        blep_integrate(n);
+    }
+
+    // advance the consumer's clock
+    uint64_t frac =
+        audio_queue.cycle_frac + (uint64_t)chunksize * audio_queue.cycles_per_sample;
+    audio_queue.cycle += (uint32_t)(frac >> 16);
+    audio_queue.cycle_frac = frac & 0xFFFF;
+}
+
+// CPU cycles' worth of audio held by the given number of internal samples
+__audio static int32_t audio_ring_cycles(uint32_t samples, int sample_replication)
+{
+    return (int32_t)((uint64_t)samples * sample_replication * AUDIO_CYCLES_PER_SAMPLE >> 16);
+}
+
+// renders the audio up to the given timestamp into audio_ring; called by the
+// emulation in the "Per frame" render mode. The clock always runs at the
+// nominal rate, so the output depends only on the emulation.
+__audio static void audio_produce(audio_data* restrict audio, const uint32_t producer_cycle)
+{
+    const int sample_replication = get_sample_replication();
+    const int32_t max_fill = (int32_t)(
+        ((uint64_t)AUDIO_QUEUE_MAX_LATENCY << 16) /
+        ((uint64_t)AUDIO_CYCLES_PER_SAMPLE * sample_replication)
+    );
+    uint32_t head = audio_ring.head;
+
+    if (!audio_queue.synced)
+    {
+        // skip ahead, once the callback has played the ring down to its target
+        audio_queue_drain(audio);
+
+        uint32_t fill = head - __atomic_load_n(&audio_ring.tail, __ATOMIC_ACQUIRE);
+        if (audio_ring_cycles(fill, sample_replication) > (int32_t)AUDIO_QUEUE_LATENCY)
+            return;
+
+        audio_queue.cycle = producer_cycle;
+        audio_queue.cycle_frac = 0;
+        audio_queue.synced = true;
+        return;
+    }
+
+    int len = audio_queue_sample_index(producer_cycle);
+    len -= len % sample_replication;
+
+    while (len > 0)
+    {
+        int chunksize = len >= AUDIO_MAX_CHUNK * sample_replication
+                            ? AUDIO_MAX_CHUNK * sample_replication
+                            : len;
+        int n = chunksize / sample_replication;
+
+        uint32_t fill = head - __atomic_load_n(&audio_ring.tail, __ATOMIC_ACQUIRE);
+        if ((int32_t)fill + n > max_fill)
+        {
+            // the callback isn't keeping up (or isn't running); drop the rest
+            audio_queue.overruns++;
+            audio_queue_drain(audio);
+            break;
+        }
+
+        audio_render_chunk(audio, chunksize, sample_replication);
+
+        for (int i = 0; i < n; ++i)
+        {
+            audio_ring.samples[(head + i) & (AUDIO_RING_SIZE - 1)] = audio_mix[i];
+        }
+
+        head += n;
+        __atomic_store_n(&audio_ring.head, head, __ATOMIC_RELEASE);
+        len -= chunksize;
+    }
+}
+
+void audio_sync(const uint32_t cycle)
+{
+    __atomic_store_n(&audio_queue.producer_cycle, cycle, __ATOMIC_RELEASE);
+
+    if (audio_queue.main_thread && audio_queue.audio)
+    {
+        audio_produce(audio_queue.audio, cycle);
+    }
+}
+
+// fills the output buffers with the ring's last sample
+__audio static void audio_ring_hold(int16_t* left, int16_t* right, int len)
+{
+    for (int i = 0; i < len; ++i)
+    {
+        left[i] = stereo_left(audio_ring.next);
+        right[i] = stereo_right(audio_ring.next);
+    }
+}
+
+// plays out the ring into the output buffers, interpolating between its
+// samples at the output rate (adjusted by rate_adjust).
+__audio static void audio_ring_play(int16_t* left, int16_t* right, int len, int step)
+{
+    uint32_t head = __atomic_load_n(&audio_ring.head, __ATOMIC_ACQUIRE);
+    uint32_t tail = audio_ring.tail;
+
+    // internal samples per output sample (16.16)
+    const uint32_t inc = (uint32_t)(
+        ((uint64_t)(AUDIO_CYCLES_PER_SAMPLE + audio_queue.rate_adjust) << 16) /
+        ((uint64_t)AUDIO_CYCLES_PER_SAMPLE * step)
+    );
+
+    uint32_t frac = audio_ring.frac;
+    stereo_t prev = audio_ring.prev;
+    stereo_t next = audio_ring.next;
+    int i = 0;
+
+    for (; i < len; ++i, frac += inc)
+    {
+        while (frac >= (1 << 16) && tail != head)
+        {
+            prev = next;
+            next = audio_ring.samples[tail++ & (AUDIO_RING_SIZE - 1)];
+            frac -= 1 << 16;
+        }
+
+        if (frac >= (1 << 16))
+            break;
+
+        // 0.15 fixed point, as in mix_output
+        const int32_t weight = frac >> 1;
+        const int32_t prev_left = stereo_left(prev);
+        const int32_t prev_right = stereo_right(prev);
+        left[i] = prev_left + (((stereo_left(next) - prev_left) * weight + (1 << 14)) >> 15);
+        right[i] = prev_right + (((stereo_right(next) - prev_right) * weight + (1 << 14)) >> 15);
+    }
+
+    __atomic_store_n(&audio_ring.tail, tail, __ATOMIC_RELEASE);
+
+    if (i < len)
+    {
+        // ran dry; hold the last sample until the ring has refilled
+        audio_queue.underruns++;
+        audio_ring.priming = true;
+        frac = 0;
+        prev = next;
+    }
+
+    audio_ring.frac = frac;
+    audio_ring.prev = prev;
+    audio_ring.next = next;
+
+    if (i < len)
+    {
+        audio_ring_hold(left + i, right + i, len - i);
+    }
+}
+
+__audio static int audio_callback_(void* context, int16_t* left, int16_t* right, int len)
+{
+    if (!audio_enabled)
+        return 0;
+
+    DTCM_VERIFY_DEBUG();
+
+    CB_GameScene** gameScene_ptr = context;
+    CB_GameScene* gameScene = *gameScene_ptr;
+
+#ifdef TARGET_SIMULATOR
+    pthread_mutex_lock(&audio_mutex);
+#endif
+
+    audio_data* audio = audio_queue.audio;
+
+    if (!gameScene || gameScene->audioLocked || !audio)
+    {
+        // keep up with the emulation even while silent
+        if (audio_queue.main_thread)
+        {
+            __atomic_store_n(
+                &audio_ring.tail, __atomic_load_n(&audio_ring.head, __ATOMIC_ACQUIRE),
+                __ATOMIC_RELEASE
+            );
+            audio_ring.priming = true;
+        }
+        else if (audio)
+        {
+            audio_queue_drain(audio);
+        }
+#ifdef TARGET_SIMULATOR
+        pthread_mutex_unlock(&audio_mutex);
+#endif
+        return 0;
+    }
+
+    int sample_replication = get_sample_replication();
+
+    if (audio_queue.main_thread)
+    {
+        // the emulation has already rendered the audio; only play it out,
+        // keeping the ring filled to a fixed distance behind the emulation
+        uint32_t fill =
+            __atomic_load_n(&audio_ring.head, __ATOMIC_ACQUIRE) - audio_ring.tail;
+        int32_t buffered = audio_ring_cycles(fill, sample_replication);
+
+        if (audio_ring.priming)
+        {
+            if (buffered < (int32_t)AUDIO_QUEUE_LATENCY)
+            {
+                audio_ring_hold(left, right, len);
+#ifdef TARGET_SIMULATOR
+                pthread_mutex_unlock(&audio_mutex);
+#endif
+                return 1;
+            }
+
+            audio_ring.priming = false;
+            audio_queue.latency = buffered;
+        }
+
+        audio_queue.latency += (buffered - audio_queue.latency) / 8;
+        audio_queue.rate_adjust =
+            audio_rate_adjust(audio_queue.latency - (int32_t)AUDIO_QUEUE_LATENCY);
+
+        audio_ring_play(left, right, len, sample_replication);
+
+#ifdef TARGET_SIMULATOR
+        pthread_mutex_unlock(&audio_mutex);
+#endif
+        return 1;
+    }
+
+    // keep a fixed distance behind the emulation
+    uint32_t producer_cycle = __atomic_load_n(&audio_queue.producer_cycle, __ATOMIC_ACQUIRE);
+    int32_t lag = (int32_t)(producer_cycle - audio_queue.cycle);
+    if (!audio_queue.synced || lag < 0 || lag > (int32_t)AUDIO_QUEUE_MAX_LATENCY)
+    {
+        if (audio_queue.synced)
+        {
+            if (lag < 0)
+                audio_queue.underruns++;
+            else
+                audio_queue.overruns++;
+        }
+
+        audio_queue.cycle = producer_cycle - AUDIO_QUEUE_LATENCY;
+        audio_queue.cycle_frac = 0;
+        audio_queue.synced = true;
+        lag = AUDIO_QUEUE_LATENCY;
+        audio_queue.latency = lag;
+    }
+
+    // frames arrive in bursts, so steer by the average distance
+    audio_queue.latency += (lag - audio_queue.latency) / 8;
+    audio_queue.rate_adjust =
+        audio_rate_adjust(audio_queue.latency - (int32_t)AUDIO_QUEUE_LATENCY);
+    audio_queue.cycles_per_sample = AUDIO_CYCLES_PER_SAMPLE + audio_queue.rate_adjust;
+
+    __builtin_prefetch(left, 1);
+    __builtin_prefetch(right, 1);
+
+    int max_chunk = AUDIO_MAX_CHUNK * sample_replication;
+
+    while (len > 0)
+    {
+        int chunksize = len >= max_chunk ? max_chunk : len;
+
+        audio_render_chunk(audio, chunksize, sample_replication);
+        mix_output(left, right, chunksize, sample_replication);
+
+        len -= chunksize;
+        left += chunksize;
+        right += chunksize;
+    }
+
+#ifdef TARGET_SIMULATOR
+    pthread_mutex_unlock(&audio_mutex);
+#endif
+
+    DTCM_VERIFY_DEBUG();
+
+    return 1;
+}
+
+/**
+ * Playdate audio callback function.
+ */
+__audio int audio_callback(void* context, int16_t* left, int16_t* right, int len)
+{
+#ifdef TARGET_SIMULATOR
+    return audio_callback_(context, left, right, len);
+#else
+    __atomic_store_n(&audio_busy, true, __ATOMIC_SEQ_CST);
+
+    int result = 0;
+    if (!__atomic_load_n(&audio_held, __ATOMIC_SEQ_CST))
+    {
+        result = audio_callback_(context, left, right, len);
+    }
+
+    __atomic_store_n(&audio_busy, false, __ATOMIC_SEQ_CST);
+    return result;
+#endif
+}
+
+// renders len output samples of a copy of the synthesiser's state, only to
+// advance it; the output is discarded.
+static void audio_advance(audio_data* restrict state, int len)
+{
+    stereo_t scratch[64];
+    int max_chunk = 64 * get_sample_replication();
+
+    while (len > 0)
+    {
+        int chunksize = len >= max_chunk ? max_chunk : len;
+        audio_render(state, scratch, NULL, chunksize);
+        len -= chunksize;
+    }
+}
+
+void audio_state_save(const audio_data* audio, void* out)
+{
+    audio_data* state = out;
+
+    audio_hold();
+
+    memcpy(state, audio, sizeof(*state));
+
+    if (audio_queue.audio == audio)
+    {
+        /* The synthesiser trails the CPU by the writes still queued; bring
+         * the copy up to the CPU's time so that the state is consistent
+         * with the rest of gb_s. */
+        const int sample_replication = get_sample_replication();
+        const int max_lag = (int)(AUDIO_QUEUE_MAX_LATENCY / DMG_CLOCK_FREQ * FREQ_INC_REF);
+        // (after a reset the consumer hasn't seen yet, it will resync)
+        const bool synced = audio_queue.synced &&
+                            audio_queue.reset_epoch == audio_queue.reset_seen;
+        uint32_t tail = audio_queue_producer_tail();
+        uint32_t head = audio_queue.head;
+        int pos = 0;
+
+        for (; tail != head; ++tail)
+        {
+            const struct audio_write_entry* entry =
+                &audio_queue.entries[tail & (AUDIO_QUEUE_SIZE - 1)];
+
+            if (synced)
+            {
+                int at = audio_queue_sample_index(entry->cycle);
+                at = at > max_lag ? max_lag : at;
+                at -= at % sample_replication;
+                if (at > pos)
+                {
+                    audio_advance(state, at - pos);
+                    pos = at;
+                }
+            }
+
+            audio_apply_write(state, entry->addr, entry->val);
+        }
+
+        if (synced)
+        {
+            int end = audio_queue_sample_index(audio_queue.producer_cycle);
+            end = end > max_lag ? max_lag : end;
+            end -= end % sample_replication;
+            audio_advance(state, end - pos);
+        }
+    }
+
+    state->audio_mem = NULL;
+
+    audio_release();
+}
+
+void audio_state_load(audio_data* audio, const void* in)
+{
+    struct chan* chans = audio->chans;
+    uint32_t blep_levels[4];
+
+    audio_hold();
+
+    /* Keep the levels that the band-limited step buffer currently holds,
+     * so that the change to the loaded state's levels is itself a step
+     * rather than an offset in the running sum. */
+    for (int i = 0; i < 4; ++i)
+    {
+        blep_levels[i] = chans[i].blep_level;
+    }
+
+    memcpy(audio, in, sizeof(*audio));
+    audio->audio_mem = audio_mem(audio);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        chans[i].blep_level = blep_levels[i];
+    }
+
+    /* Writes in flight belong to the previous timeline; the callback skips
+     * them, and resyncs to the loaded state's time, on its next run. */
+    audio_queue_reset();
+    audio_queue.dropped[0] = audio_queue.dropped[1] = 0;
+    audio_queue.dropped_triggers = 0;
+    audio_queue.audio = audio;
+
+    /* Recompute state derived from the registers. */
+    wave_table_rebuild(audio);
+    chan_update_gains(audio);
+    chan_enable(audio, 0, chans[0].enabled);
+
+    audio_release();
+}
+
+unsigned audio_get_state_size(void)
+{
+    return sizeof(audio_data);
+}
+
+void audio_get_stats(struct audio_stats* stats)
+{
+    stats->underruns = audio_queue.underruns;
+    stats->overruns = audio_queue.overruns;
+    stats->overflows = audio_queue.overflows;
+    stats->latency = audio_queue.synced ? audio_queue.latency : 0;
+    stats->rate_ppm =
+        (int32_t)((int64_t)audio_queue.rate_adjust * 1000000 / AUDIO_CYCLES_PER_SAMPLE);
+}
+
+int audio_frame_correction(void)
+{
+    static int holdoff;
+
+    if (holdoff > 0)
+    {
+        holdoff--;
+        return 0;
+    }
+
+    if (!audio_enabled || !audio_queue.synced)
+        return 0;
+
+    if (audio_queue.main_thread && audio_ring.priming)
+        return 0;
+
+    int32_t error = audio_queue.latency - (int32_t)AUDIO_QUEUE_LATENCY;
+    if (error > -AUDIO_FRAME_CORRECTION_THRESHOLD && error < AUDIO_FRAME_CORRECTION_THRESHOLD)
+        return 0;
+
+    holdoff = AUDIO_FRAME_CORRECTION_HOLDOFF;
+    return error < 0 ? 1 : -1;
 }
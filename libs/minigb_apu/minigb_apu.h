@@ -66,6 +66,14 @@ struct chan
 
     int_fast16_t val;
 
+    // NR50 volume of each side the channel is routed to by NR51, else 0
+    uint8_t gain_left;
+    uint8_t gain_right;
+
+    // output level currently represented in the band-limited step buffer,
+    // packed as left and right int16 halves
+    uint32_t blep_level;
+
     struct chan_len_ctr len;
     struct chan_vol_env env;
     struct chan_freq_sweep sweep;
@@ -79,7 +87,8 @@ struct chan
         } square;
         struct
         {
-            uint16_t lfsr_reg;
+            // clocks since trigger, modulo the LFSR's period
+            uint16_t lfsr_pos;
             uint8_t lfsr_div;
         } noise;
         struct
@@ -94,6 +103,16 @@ typedef struct audio_data
     int vol_l : 4;
     int vol_r : 4;
     uint8_t* audio_mem;
+
+    // Registers 0xFF10-0xFF3F as seen by the synthesiser. Unlike the CPU's
+    // view (in hram), writes only arrive here once the audio callback
+    // reaches their timestamp.
+    uint8_t regs[0x30];
+
+    // wave RAM decoded and shifted for the wave channel's volume; kept up to
+    // date as wave RAM and NR32 are written.
+    int16_t wave_table[32];
+
     struct chan chans[4];
 } audio_data;
 
@@ -104,19 +123,73 @@ uint8_t audio_read(struct audio_data* audio, const uint16_t addr);
 
 /**
  * Write "val" to audio register at given address "addr".
+ * "cycle" is the CPU cycle at which the write occurred. The write is queued
+ * and applied by the audio callback at the corresponding output sample.
+ */
+void audio_write(
+    struct audio_data* audio, const uint16_t addr, const uint8_t val, const uint32_t cycle
+);
+
+/**
+ * Called by the core at the end of each frame; all writes timestamped
+ * before "cycle" have been queued. The audio callback trails this by a
+ * fixed latency. In the "Per frame" render mode (preferences_sound_render),
+ * this also renders the audio up to "cycle" for the callback to play out.
  */
-void audio_write(struct audio_data* audio, const uint16_t addr, const uint8_t val);
+void audio_sync(const uint32_t cycle);
 
 /**
  * Initialise audio driver.
  */
 void audio_init(audio_data* audio);
 
+/**
+ * Initialise audio driver, then bring the synthesiser up to the register
+ * values (0xFF10-0xFF3F) the CPU currently sees, leaving those unchanged.
+ * For loading states which hold no usable synthesiser state.
+ */
+void audio_init_from_regs(audio_data* audio);
+
 /**
  * Playdate audio callback function.
  */
 int audio_callback(void* context, int16_t* left, int16_t* right, int len);
 
+struct audio_stats
+{
+    // times the audio callback caught up with the emulation (underrun), or
+    // fell too far behind it (overrun), and had to resync
+    uint32_t underruns;
+    uint32_t overruns;
+
+    // register writes which didn't fit in the queue, and were applied later
+    // from the CPU's view of the registers instead
+    uint32_t overflows;
+
+    // how far the callback trails the emulation, in CPU cycles (smoothed);
+    // in the "Per frame" render mode, how much audio is buffered
+    int32_t latency;
+
+    // the callback's current clock adjustment, in parts per million
+    int32_t rate_ppm;
+};
+
+void audio_get_stats(struct audio_stats* stats);
+
+/**
+ * Called once per displayed frame (batch). If the callback's latency has
+ * drifted well off target despite its rate adjustment, returns 1 to ask
+ * for an extra emulated frame, or -1 to ask for one fewer; otherwise 0.
+ */
+int audio_frame_correction(void);
+
+/**
+ * Save states and snapshots. The saved state is the synthesiser's, brought
+ * up to the time of the last audio_sync() by replaying the writes still
+ * queued for the callback, so it is consistent with the CPU's view of the
+ * registers. Loading discards any queued writes; the callback then resyncs.
+ * The audio callback must not be rendering meanwhile (see audioLocked).
+ */
 unsigned audio_get_state_size(void);
-void audio_state_save(void* buff);
-void audio_state_load(const void* buff);
+void audio_state_save(const struct audio_data* audio, void* out);
+void audio_state_load(struct audio_data* audio, const void* in);
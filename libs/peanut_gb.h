@@ -32,6 +32,7 @@
 #ifndef PEANUT_GB_H
 #define PEANUT_GB_H
 
+#include "../libs/lz4/lz4.h"
 #include "../libs/minigb_apu/minigb_apu.h"
 #include "../src/app.h"
 #include "../src/preferences.h"
@@ -201,7 +202,7 @@ typedef int16_t s16;
 #define PEANUT_GB_ARRAYSIZE(array) (sizeof(array) / sizeof(array[0]))
 
 #define CB_SAVE_STATE_MAGIC "\xFA\x43\42sav\n\x1A"
-#define CB_SAVE_STATE_VERSION 0
+#define CB_SAVE_STATE_VERSION 2
 
 #define IO_PLAYDATE_EXTENSION_CTL 0x57
 #define IO_PLAYDATE_EXTENSION_CRANK_LO 0x58
@@ -418,6 +419,10 @@ struct gb_s
     void (*gb_serial_tx)(struct gb_s*, const uint8_t tx);
     enum gb_serial_rx_ret_e (*gb_serial_rx)(struct gb_s*, uint8_t* rx);
 
+    /* Called the first time the guest reads P1 in a frame, if
+     * direct.late_input is set, so the front-end can refresh direct.joypad. */
+    void (*gb_input_poll)(struct gb_s*);
+
     // shortcut to swappable bank (addr - 0x4000 offset built in)
     uint8_t* selected_bank_addr;
 
@@ -456,6 +461,11 @@ struct gb_s
 
     uint8_t overclock : 2;
 
+    // if set, overclock is adjusted each frame between 0 and overclock_max
+    // according to whether the guest is lagging (see lag, below.)
+    uint8_t overclock_auto : 1;
+    uint8_t overclock_max : 2;
+
     uint8_t* selected_cart_bank_addr;
 
     /* Number of ROM banks in cartridge. */
@@ -577,6 +587,13 @@ struct gb_s
         uint8_t joypad_interrupts : 1;
         uint8_t enable_xram : 1;
 
+        // if set, gb_input_poll is invoked at the first P1 read each frame
+        uint8_t late_input : 1;
+        uint8_t input_polled : 1;
+
+        // incremented each time gb_input_poll is invoked; front-end may reset
+        uint16_t input_polls;
+
         int joypad_interrupt_delay;
 
         // if set, causes crank register to behave as delta-menu-selection instead
@@ -622,6 +639,47 @@ struct gb_s
         void* priv;
     } direct;
 
+    /**
+     * Lag-frame detection. A frame is considered lagged if the guest took a
+     * VBlank interrupt without having entered HALT (with the VBlank interrupt
+     * enabled) since the previous one, i.e. its main loop did not finish in
+     * time to wait for the next frame. HALTs which can only be woken by other
+     * interrupts don't count, and frames in which VBlank wasn't taken aren't
+     * judged. Guests which never HALT (busy-waiting on a flag instead) can't
+     * be judged this way, so nothing is counted for them until a HALT is seen.
+     *
+     * Written by the core; read-only for the front-end (other than to
+     * reset the totals.)
+     */
+    struct
+    {
+        // counters for the frame in progress (saturating)
+        uint8_t halts;  // HALTs entered with VBlank enabled in IE
+        uint8_t vblank_acks;
+
+        // counters for the most recently completed frame
+        uint8_t prev_halts;
+        uint8_t prev_vblank_acks;
+
+        uint8_t in_halt : 1;
+        uint8_t prev_lagged : 1;
+
+        // frames remaining until we stop trusting HALT as a frame marker
+        uint8_t halt_seen;
+
+        // consecutive non-lagged frames; used to step overclock back down
+        uint8_t calm_frames;
+
+        // totals since last reset
+        uint32_t frames;
+        uint32_t lag_frames;
+        uint32_t overclocked_frames;
+    } lag;
+
+    // Free-running CPU cycle count at the start of the current frame, used
+    // to timestamp APU register writes. Only differences are meaningful.
+    uint32_t audio_cycles;
+
     uint32_t gb_cart_ram_size;
 
     gb_breakpoint* breakpoints;
@@ -864,6 +922,35 @@ static uint8_t gb_original_rom[0x100];
 // extended ram feature offered by crankboy
 static uint8_t xram[0x100 - 0xA0];
 
+// Dirty-page tracking for snapshot deltas (see gb_snapshot_delta_save).
+// WRAM, VRAM and cartridge RAM are numbered as one run of 256-byte pages.
+// Each page has one bit per snapshot base ("track"), set by any write and
+// cleared when that base is brought up to date, so marking a page is a
+// single byte store on the write paths.
+#define GB_SNAPSHOT_PAGE_SIZE 0x100
+#define GB_SNAPSHOT_WRAM_PAGE 0
+#define GB_SNAPSHOT_VRAM_PAGE (WRAM_SIZE / GB_SNAPSHOT_PAGE_SIZE)
+#define GB_SNAPSHOT_CRAM_PAGE (GB_SNAPSHOT_VRAM_PAGE + VRAM_SIZE / GB_SNAPSHOT_PAGE_SIZE)
+#define GB_SNAPSHOT_MAX_PAGES (GB_SNAPSHOT_CRAM_PAGE + 0x20000 / GB_SNAPSHOT_PAGE_SIZE)
+#define GB_SNAPSHOT_TRACKS 8
+
+static uint8_t gb_dirty_pages[GB_SNAPSHOT_MAX_PAGES];
+
+#define __gb_mark_dirty(page) (gb_dirty_pages[(page)] = 0xFF)
+#define __gb_mark_dirty_wram(offset) \
+    __gb_mark_dirty(GB_SNAPSHOT_WRAM_PAGE + (offset) / GB_SNAPSHOT_PAGE_SIZE)
+#define __gb_mark_dirty_vram(offset) \
+    __gb_mark_dirty(GB_SNAPSHOT_VRAM_PAGE + (offset) / GB_SNAPSHOT_PAGE_SIZE)
+#define __gb_mark_dirty_cram(offset) \
+    __gb_mark_dirty(GB_SNAPSHOT_CRAM_PAGE + (offset) / GB_SNAPSHOT_PAGE_SIZE)
+
+// marks every page dirty for every track, e.g. after memory is replaced
+// wholesale.
+static void gb_snapshot_dirty_all(void)
+{
+    memset(gb_dirty_pages, 0xFF, sizeof(gb_dirty_pages));
+}
+
 __section__(".rare.cb") static void __gb_rare_write(
     struct gb_s* gb, const uint16_t addr, const uint8_t val
 )
@@ -1138,6 +1225,16 @@ __shell uint8_t __gb_read_full(struct gb_s* gb, const uint_fast16_t addr)
         /* IO Registers */
         case 0x00:  // P1 / JOYP
         {
+            if unlikely (gb->direct.late_input && !gb->direct.input_polled)
+            {
+                gb->direct.input_polled = 1;
+                if (gb->gb_input_poll)
+                {
+                    gb->direct.input_polls++;
+                    gb->gb_input_poll(gb);
+                }
+            }
+
             uint8_t p1_val = gb->gb_reg.P1;
             uint8_t joypad_val = gb->direct.joypad;
             uint8_t result = 0xFF;  // Default to all high (no buttons pressed, all lines high)
@@ -1318,6 +1415,28 @@ __core_section("bgcache") void __gb_update_bgcache_tile_data(
     }
 }
 
+// regenerates the whole bgcache (both tilemaps, both addressing modes) in
+// one pass over the tilemaps, e.g. after VRAM is replaced wholesale.
+// Far cheaper than marking every tile's data dirty, as each of those
+// rescans both tilemaps.
+__section__(".rare") void __gb_rebuild_bgcache(struct gb_s* restrict gb)
+{
+    for (int tmidx = 0; tmidx < 0x800; ++tmidx)
+    {
+        const uint8_t tile = gb->vram[0x1800 + tmidx];
+        __gb_update_bgcache_tile(gb, 0, tmidx, tile);
+        __gb_update_bgcache_tile(gb, 1, tmidx, tile);
+    }
+
+#if ENABLE_BGCACHE_DEFERRED
+    // nothing is left to process
+    gb->dirty_tile_data_master = 0;
+    memset(gb->dirty_tile_data, 0, sizeof(gb->dirty_tile_data));
+    gb->dirty_tile_rows = 0;
+    memset(gb->dirty_tiles, 0, sizeof(gb->dirty_tiles));
+#endif
+}
+
 #if ENABLE_BGCACHE_DEFERRED
 __core_section("bgdefer") void __gb_process_deferred_tile_data_update(struct gb_s* restrict gb)
 {
@@ -1448,8 +1567,11 @@ __section__(".text.cb") static void __gb_mbc7_eeprom_clock(struct gb_s* gb)
                 else if ((gb->mbc7.eeprom_shift_reg >> 5) == 0b0010) /* ERAL */
                 {
                     if (gb->mbc7.eeprom_write_enabled)
+                    {
                         for (int i = 0; i < 128; i++)
                             ((uint16_t*)gb->gb_cart_ram)[i] = 0xFFFF;
+                        __gb_mark_dirty_cram(0);
+                    }
                 }
                 else if ((gb->mbc7.eeprom_shift_reg >> 5) == 0b0001) /* WRAL */
                 {
@@ -1479,7 +1601,10 @@ __section__(".text.cb") static void __gb_mbc7_eeprom_clock(struct gb_s* gb)
 
             case 0b11: /* ERASE */
                 if (gb->mbc7.eeprom_write_enabled)
+                {
                     ((uint16_t*)gb->gb_cart_ram)[gb->mbc7.eeprom_addr] = 0xFFFF;
+                    __gb_mark_dirty_cram(gb->mbc7.eeprom_addr * sizeof(uint16_t));
+                }
                 break;
             }
         }
@@ -1522,6 +1647,27 @@ __core static void __gb_check_lyc(struct gb_s* gb)
     }
 }
 
+/**
+ * Timestamp (in CPU cycles) of the current position within the frame,
+ * for APU register writes. Frames begin at VBlank (see gb_run_frame).
+ */
+static inline uint32_t __gb_audio_timestamp(const struct gb_s* gb)
+{
+    uint32_t pos;
+    if (gb->gb_reg.LCDC & LCDC_ENABLE)
+    {
+        unsigned line = gb->gb_reg.LY + (LCD_VERT_LINES - LCD_HEIGHT);
+        if (line >= LCD_VERT_LINES)
+            line -= LCD_VERT_LINES;
+        pos = line * LCD_LINE_CYCLES + gb->counter.lcd_count;
+    }
+    else
+    {
+        pos = gb->counter.lcd_off_count;
+    }
+    return gb->audio_cycles + pos;
+}
+
 /**
  * Internal function used to write bytes.
  */
@@ -1637,6 +1783,7 @@ __shell void __gb_write_full(struct gb_s* gb, const uint_fast16_t addr, const ui
 
     case 0x8:
     case 0x9:
+        __gb_mark_dirty_vram(addr - VRAM_ADDR);
 #if ENABLE_BGCACHE
         __gb_write_vram(gb, addr, val);
 #else
@@ -1663,6 +1810,7 @@ __shell void __gb_write_full(struct gb_s* gb, const uint_fast16_t addr, const ui
                         const u8 prev = gb->gb_cart_ram[ram_addr];
                         gb->direct.sram_updated |= prev != value_to_write;
                         gb->gb_cart_ram[ram_addr] = value_to_write;
+                        __gb_mark_dirty_cram(ram_addr);
                     }
                 }
             }
@@ -1718,6 +1866,7 @@ __shell void __gb_write_full(struct gb_s* gb, const uint_fast16_t addr, const ui
                 const u8 prev = gb->gb_cart_ram[idx];
                 gb->gb_cart_ram[idx] = val;
                 gb->direct.sram_updated |= prev != val;
+                __gb_mark_dirty_cram(idx);
             }
             else if (gb->num_ram_banks)
             {
@@ -1726,26 +1875,31 @@ __shell void __gb_write_full(struct gb_s* gb, const uint_fast16_t addr, const ui
                 const u8 prev = gb->gb_cart_ram[idx];
                 gb->gb_cart_ram[idx] = val;
                 gb->direct.sram_updated |= prev != val;
+                __gb_mark_dirty_cram(idx);
             }
         }
         return;
 
     case 0xC:
         gb->wram[addr - WRAM_0_ADDR] = val;
+        __gb_mark_dirty_wram(addr - WRAM_0_ADDR);
         return;
 
     case 0xD:
         gb->wram[addr - WRAM_1_ADDR + WRAM_BANK_SIZE] = val;
+        __gb_mark_dirty_wram(addr - WRAM_1_ADDR + WRAM_BANK_SIZE);
         return;
 
     case 0xE:
         gb->wram[addr - ECHO_ADDR] = val;
+        __gb_mark_dirty_wram(addr - ECHO_ADDR);
         return;
 
     case 0xF:
         if (addr < OAM_ADDR)
         {
             gb->wram[addr - ECHO_ADDR] = val;
+            __gb_mark_dirty_wram(addr - ECHO_ADDR);
             return;
         }
 
@@ -1769,7 +1923,7 @@ __shell void __gb_write_full(struct gb_s* gb, const uint_fast16_t addr, const ui
         {
             if (gb->direct.sound)
             {
-                audio_write(&gb->audio, addr, val);
+                audio_write(&gb->audio, addr, val, __gb_audio_timestamp(gb));
             }
             else
             {
@@ -1976,6 +2130,7 @@ __core_section("short") static void __gb_write(
     if likely (addr >= 0xC000 && addr < 0xE000)
     {
         gb->wram[addr % WRAM_SIZE] = v;
+        __gb_mark_dirty_wram(addr % WRAM_SIZE);
         return;
     }
     if likely (addr >= 0xFF80 && addr <= 0xFFFE)
@@ -5331,6 +5486,7 @@ __core static unsigned __gb_run_instruction_micro(struct gb_s* gb)
 __shell static void __gb_interrupt(struct gb_s* gb)
 {
     gb->gb_halt = 0;
+    gb->lag.in_halt = 0;
 
     if (gb->gb_ime)
     {
@@ -5346,6 +5502,8 @@ __shell static void __gb_interrupt(struct gb_s* gb)
         {
             gb->cpu_reg.pc = VBLANK_INTR_ADDR;
             gb->gb_reg.IF ^= VBLANK_INTR;
+            if (gb->lag.vblank_acks < UINT8_MAX)
+                gb->lag.vblank_acks++;
         }
         else if (gb->gb_reg.IF & gb->gb_reg.IE & LCDC_INTR)
         {
@@ -5370,6 +5528,56 @@ __shell static void __gb_interrupt(struct gb_s* gb)
     }
 }
 
+// how many frames a HALT keeps lag detection trusted
+#define LAG_HALT_MEMORY 60
+
+// non-lagged frames before automatic overclock steps down one level
+#define LAG_CALM_FRAMES 30
+
+// called on entry to VBlank; tallies the frame just completed and,
+// if enabled, adjusts the overclock for the coming VBlank period.
+__shell static void __gb_end_lag_frame(struct gb_s* gb)
+{
+    bool lagged = false;
+
+    if (gb->lag.halts)
+    {
+        gb->lag.halt_seen = LAG_HALT_MEMORY;
+    }
+    else if (gb->lag.halt_seen)
+    {
+        gb->lag.halt_seen--;
+        // (no VBlank taken, e.g. with the LCD off: nothing to judge by)
+        lagged = gb->lag.vblank_acks != 0;
+    }
+
+    gb->lag.frames++;
+    gb->lag.lag_frames += lagged;
+    gb->lag.overclocked_frames += (gb->overclock != 0);
+    gb->lag.prev_lagged = lagged;
+    gb->lag.prev_halts = gb->lag.halts;
+    gb->lag.prev_vblank_acks = gb->lag.vblank_acks;
+    gb->lag.halts = 0;
+    gb->lag.vblank_acks = 0;
+
+    if (gb->overclock_auto)
+    {
+        if (lagged)
+        {
+            gb->lag.calm_frames = 0;
+            if (gb->overclock < gb->overclock_max)
+                gb->overclock++;
+        }
+        else if (gb->overclock > 0 && ++gb->lag.calm_frames >= LAG_CALM_FRAMES)
+        {
+            gb->lag.calm_frames = 0;
+            gb->overclock--;
+        }
+        if (gb->overclock > gb->overclock_max)
+            gb->overclock = gb->overclock_max;
+    }
+}
+
 __shell static uint16_t __gb_calc_halt_cycles(struct gb_s* gb)
 {
     int src[] = {512, 512, 512};
@@ -5423,6 +5631,12 @@ __core unsigned int __gb_step_cpu(struct gb_s* gb)
 
     if unlikely (gb->gb_halt)
     {
+        if unlikely (!gb->lag.in_halt)
+        {
+            gb->lag.in_halt = 1;
+            if ((gb->gb_reg.IE & VBLANK_INTR) && gb->lag.halts < UINT8_MAX)
+                gb->lag.halts++;
+        }
         inst_cycles = __gb_calc_halt_cycles(gb);
         goto done_instr;
     }
@@ -5721,6 +5935,8 @@ done_instr:
                     gb->gb_reg.IF |= VBLANK_INTR;
                     gb->lcd_blank = 0;
 
+                    __gb_end_lag_frame(gb);
+
                     if (gb->gb_reg.STAT & STAT_MODE_1_INTR)
                         gb->gb_reg.IF |= LCDC_INTR;
                 }
@@ -5788,6 +6004,7 @@ done_instr:
 __core void gb_run_frame(struct gb_s* gb)
 {
     gb->gb_frame = 0;
+    gb->direct.input_polled = 0;
     unsigned int total_cycles = 0;
 
     while (!gb->gb_frame && total_cycles < SCREEN_REFRESH_CYCLES)
@@ -5800,6 +6017,12 @@ __core void gb_run_frame(struct gb_s* gb)
         f
 #endif
     }
+
+    gb->audio_cycles += LCD_FRAME_CYCLES;
+    if (gb->direct.sound)
+    {
+        audio_sync(gb->audio_cycles);
+    }
 }
 
 #define ROM_HEADER_START 0x134
@@ -5822,147 +6045,511 @@ struct StateHeader
     // Custom field for CrankBoy timestamp.
     uint32_t timestamp;
 
-    char reserved[20];
-};
+    // since version 2: layout of the gb struct in the CB_STATE_CHUNK_GB
+    // chunk (see __gb_state_layout)
+    uint32_t layout;
 
-// Note: this version can be used on unswizzled structs,
-// i.e. no pointers should be followed
-__section__(".rare") uint32_t gb_get_state_size(struct gb_s* gb)
-{
-    return sizeof(struct StateHeader) + sizeof(struct gb_s) + ROM_HEADER_SIZE  // for safe-keeping
-           + WRAM_SIZE + VRAM_SIZE + sizeof(xram) + gb->gb_cart_ram_size +
-           MAX_BREAKPOINTS * sizeof(gb_breakpoint);
+    char reserved[16];
+};
 
-    // skipped: lcd; bgcache; rom
-}
+/**
+ * Save states.
+ *
+ * Since version 1, a state is its header followed by a sequence of chunks,
+ * each LZ4-compressed (or stored as-is, if that is no smaller) and carrying
+ * a CRC32 of its stored bytes. The loader looks chunks up by type and skips
+ * any it doesn't need, so new chunks can be added without breaking older
+ * states. Version 0 states held the same data uncompressed, in a fixed
+ * layout (struct gb_s_v0); they can still be loaded, less the APU's state.
+ *
+ * The gb struct is stored twice: as it is in memory, which is loaded with a
+ * straight memcpy by a build with the same layout, and since version 2 as
+ * the fields listed in gb_state_fields.x, in a fixed little-endian form
+ * which any build can load (e.g. a state from the 64-bit simulator on a
+ * Playdate). The APU's state is only loaded from a build with the same
+ * layout; otherwise the APU is reset.
+ */
 
-__section__(".rare") void gb_state_save(struct gb_s* gb, char* out)
+#define CB_STATE_CHUNK_GB 1          // gb struct up to the APU: CPU, IO, MBC, ...
+#define CB_STATE_CHUNK_ROM_HEADER 2  // so we know the associated rom for this state
+#define CB_STATE_CHUNK_WRAM 3
+#define CB_STATE_CHUNK_VRAM 4
+#define CB_STATE_CHUNK_XRAM 5
+#define CB_STATE_CHUNK_CART_RAM 6
+#define CB_STATE_CHUNK_APU 7
+#define CB_STATE_CHUNK_BREAKPOINTS 8  // set by scripts
+#define CB_STATE_CHUNK_GB_FIELDS 9    // portable form of CB_STATE_CHUNK_GB
+
+struct StateChunk
 {
-    // header
-    struct StateHeader header;
-    memset(&header, 0, sizeof(header));
-    CB_ASSERT(strlen(CB_SAVE_STATE_MAGIC) == sizeof(header.magic));
-    memcpy(header.magic, CB_SAVE_STATE_MAGIC, sizeof(header.magic));
-    header.version = CB_SAVE_STATE_VERSION;
-#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
-    header.big_endian = 1;
-#else
-    header.big_endian = 0;
-#endif
-    header.bits = sizeof(void*);
-    memcpy(out, &header, sizeof(header));
-    out += sizeof(header);
-
-    // gb
-    memcpy(out, gb, sizeof(*gb));
-    out += sizeof(*gb);
-
-    // rom header (so we know the associated rom for this state)
-    memcpy(out, gb->gb_rom + ROM_HEADER_START, ROM_HEADER_SIZE);
-    out += ROM_HEADER_SIZE;
-
-    // wram
-    memcpy(out, gb->wram, WRAM_SIZE);
-    out += WRAM_SIZE;
+    uint32_t type;
+    uint32_t size;         // uncompressed
+    uint32_t packed_size;  // as stored; equal to size if stored as-is
+    uint32_t crc32;        // of the stored bytes
 
-    // vram
-    memcpy(out, gb->vram, VRAM_SIZE);
-    out += VRAM_SIZE;
+    // followed by the stored bytes
+};
 
-    // xram
-    memcpy(out, xram, sizeof(xram));
-    out += sizeof(xram);
+// The gb struct (and APU) as version 0 states stored them, frozen so that
+// those states can still be read whatever gb_s has become since. Only the
+// fields in gb_state_fields.x and gb_cart_ram_size are read from it.
+struct gb_s_v0
+{
+    uint8_t* gb_rom;
+    uint8_t* gb_cart_ram;
+    void (*gb_error)(struct gb_s*, const enum gb_error_e, const uint16_t val);
+    void (*gb_serial_tx)(struct gb_s*, const uint8_t tx);
+    enum gb_serial_rx_ret_e (*gb_serial_rx)(struct gb_s*, uint8_t* rx);
+    uint8_t* selected_bank_addr;
 
-    // cart ram
-    if (gb->gb_cart_ram_size > 0)
+    struct
     {
-        memcpy(out, gb->gb_cart_ram, gb->gb_cart_ram_size);
-        out += gb->gb_cart_ram_size;
-    }
-
-    // breakpoints
-    memcpy(out, gb->breakpoints, MAX_BREAKPOINTS * sizeof(gb_breakpoint));
-    out += MAX_BREAKPOINTS * sizeof(gb_breakpoint);
-
-    // intentionally skipped: lcd; bgcache; rom
+        uint8_t gb_halt : 1;
+        uint8_t gb_ime : 1;
+        uint8_t gb_bios_enable : 1;
+        uint8_t gb_frame : 1;
+        uint8_t lcd_mode : 2;
+        uint8_t lcd_blank : 1;
+        uint8_t lcd_master_enable : 1;
+    };
 
-    // TODO: audio
-}
+    uint8_t mbc;
+    uint8_t cart_ram : 1;
+    uint8_t cart_battery : 1;
+    uint8_t enable_cart_ram : 1;
+    uint8_t cart_mode_select : 1;
+    uint8_t joypad_interrupt : 1;
+    uint8_t overclock : 2;
+    uint8_t* selected_cart_bank_addr;
+    uint16_t num_rom_banks_mask;
+    uint8_t num_ram_banks;
+    uint16_t selected_rom_bank;
+    uint8_t cart_ram_bank;
+    uint8_t rtc_latch_s1;
+    uint8_t latched_rtc[5];
 
-// returns NULL on success; error message otherwise
-// if failure, no change is made to gb.
-// Note: provided gb must already be initialized for the given ROM;
-// in particular, it needs to have a gb_cart_ram field init'd with the correct
-// size, and rom needs to be already loaded.
-__section__(".rare") const char* gb_state_load(struct gb_s* gb, const char* in, size_t size)
-{
-    // at least enough to read save header, rom header, and gb struct fields
-    if (size < sizeof(struct StateHeader) + sizeof(struct gb_s) + ROM_HEADER_SIZE)
+    union
     {
-        return "State size too small";
-    }
+        uint8_t cart_rtc[5];
 
-    struct StateHeader* header = (struct StateHeader*)in;
-    in += sizeof(struct StateHeader);
+        struct
+        {
+            uint8_t ram_enable_1;
+            uint8_t ram_enable_2;
+            uint8_t accel_latch_state;
+            uint16_t accel_x_latched;
+            uint16_t accel_y_latched;
+            uint8_t eeprom_pins;
+            uint8_t eeprom_state;
+            uint8_t eeprom_write_enabled;
+            uint16_t eeprom_shift_reg;
+            uint8_t eeprom_bits_shifted;
+            uint8_t eeprom_addr;
+            uint16_t eeprom_read_buffer;
+        } mbc7;
+    };
 
-    if (strncmp(header->magic, CB_SAVE_STATE_MAGIC, sizeof(header->magic)))
+    union
     {
-        return "Not a CrankBoy savestate";
-    }
+        struct cpu_registers_s cpu_reg;
+        uint8_t cpu_reg_raw[12];
+        uint16_t cpu_reg_raw16[6];
+    };
+    struct gb_registers_s gb_reg;
+    struct count_s counter;
 
-    if (header->version < CB_SAVE_STATE_VERSION)
-    {
-        return "State comes from an incompatible older version of CrankBoy";
-    }
+    uint8_t* wram;
+    uint8_t* vram;
+    uint8_t hram[HRAM_SIZE];
+    uint8_t oam[OAM_SIZE];
+    uint8_t* lcd;
 
-    if (header->version > CB_SAVE_STATE_VERSION)
+    struct
     {
-        return "State comes from an incompatible future version of CrankBoy";
-    }
+        uint8_t bg_palette[4];
+        uint8_t sp_palette[8];
+        uint8_t window_clear;
+        uint8_t WY;
+    } display;
 
-    if (header->bits != sizeof(void*))
+    struct
     {
-        return "State 64-bit/32-bit mismatch (note: Playdate/Simulator states "
-               "cannot be shared)";
-    }
+        uint8_t frame_skip : 1;
+        uint8_t sound : 1;
+        uint8_t dynamic_rate_enabled : 1;
+        uint8_t transparency_enabled : 1;
+        uint8_t sram_updated : 1;
+        uint8_t sram_dirty : 1;
+        uint8_t crank_docked : 1;
+        uint8_t joypad_interrupts : 1;
+        uint8_t enable_xram : 1;
+        int joypad_interrupt_delay;
+        uint8_t ext_crank_menu_indexing : 1;
+        uint8_t interlace_mask;
+        uint8_t joypad;
+        uint16_t peripherals[4];
+        uint16_t crank_menu_accumulation;
+        int8_t crank_menu_delta;
+        void* priv;
+    } direct;
 
-#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
-    if (!header->big_endian)
-#else
-    if (header->big_endian)
+    uint32_t gb_cart_ram_size;
+    gb_breakpoint* breakpoints;
+
+#if ENABLE_BGCACHE
+    uint8_t* bgcache;
+#if ENABLE_BGCACHE_DEFERRED
+    bool dirty_tile_data_master : 1;
+    uint32_t dirty_tile_data[0x180 / 32];
+    uint64_t dirty_tile_rows;
+    uint32_t dirty_tiles[64];
+#endif
 #endif
-    {
-        return "State endianness incorrect";
-    }
 
-    struct gb_s* in_gb = (struct gb_s*)(void*)in;
-    in += sizeof(*gb);
-    size_t state_size = gb_get_state_size(in_gb);
+    size_t gb_rom_size;
+    uint8_t* gb_boot_rom;
 
-    if (size != state_size)
+    struct
     {
-        return "State size mismatch";
-    }
+        int vol_l : 4;
+        int vol_r : 4;
+        uint8_t* audio_mem;
 
-    if (gb->gb_cart_ram_size != in_gb->gb_cart_ram_size)
-    {
-        return "Cartridge RAM size mismatch";
-    }
+        struct
+        {
+            unsigned enabled : 1;
+            unsigned powered : 1;
+            unsigned on_left : 1;
+            unsigned on_right : 1;
+            unsigned muted : 1;
+            uint8_t lfsr_wide : 1;
+            unsigned sweep_up : 1;
+            unsigned len_enabled : 1;
+            uint8_t volume : 4;
+            uint8_t volume_init : 4;
+            uint16_t freq;
+            uint32_t freq_counter;
+            uint32_t freq_inc;
+            int_fast16_t val;
 
-    const uint8_t* in_rom_header = (const uint8_t*)in;
-    const uint8_t* gb_rom_header = gb->gb_rom + ROM_HEADER_START;
-    if (memcmp(in_rom_header, gb_rom_header, 15))
-    {
-        return "State appears to be for a different ROM";
-    }
-    in += ROM_HEADER_SIZE;
+            struct
+            {
+                uint8_t load;
+                uint32_t counter;
+                uint32_t inc;
+            } len;
+            struct
+            {
+                uint8_t step : 3;
+                unsigned up : 1;
+                uint32_t counter;
+                uint32_t inc;
+            } env;
+            struct
+            {
+                uint16_t freq;
+                uint8_t rate;
+                uint8_t shift;
+                uint32_t counter;
+                uint32_t inc;
+            } sweep;
 
-    // -- we're in the clear now --
+            union
+            {
+                struct
+                {
+                    uint8_t duty;
+                    uint8_t duty_counter;
+                } square;
+                struct
+                {
+                    uint16_t lfsr_reg;
+                    uint8_t lfsr_div;
+                } noise;
+                struct
+                {
+                    int8_t sample;
+                } wave;
+            };
+        } chans[4];
+    } audio;
+};
+
+// Size of a version 0 state.
+// Note: this can be used on unswizzled structs, i.e. no pointers are followed
+__section__(".rare") static uint32_t __gb_state_v0_size(const struct gb_s_v0* gb)
+{
+    return sizeof(struct StateHeader) + sizeof(struct gb_s_v0) +
+           ROM_HEADER_SIZE  // for safe-keeping
+           + WRAM_SIZE + VRAM_SIZE + sizeof(xram) + gb->gb_cart_ram_size +
+           MAX_BREAKPOINTS * sizeof(gb_breakpoint);
+
+    // skipped: lcd; bgcache; rom
+}
+
+static inline void __gb_state_put(uint8_t** out, uint32_t value, unsigned bytes)
+{
+    for (unsigned i = 0; i < bytes; ++i)
+    {
+        *(*out)++ = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static inline uint32_t __gb_state_get(const uint8_t** in, unsigned bytes)
+{
+    uint32_t value = 0;
+    for (unsigned i = 0; i < bytes; ++i)
+    {
+        value |= (uint32_t)*(*in)++ << (8 * i);
+    }
+    return value;
+}
+
+// size of the CB_STATE_CHUNK_GB_FIELDS chunk's data
+__section__(".rare") static uint32_t __gb_state_fields_size(const struct gb_s* gb)
+{
+    uint32_t size = 0;
+#define FIELD(member, bytes, condition) size += (condition) ? (bytes) : 0;
+#define ARRAY(member, condition) size += (condition) ? sizeof(gb->member) : 0;
+#include "gb_state_fields.x"
+    return size;
+}
+
+__section__(".rare") static uint32_t __gb_state_fields_save(const struct gb_s* gb, uint8_t* out)
+{
+    const uint8_t* start = out;
+#define FIELD(member, bytes, condition)                \
+    if (condition)                                     \
+    {                                                  \
+        __gb_state_put(&out, (gb->member), (bytes));   \
+    }
+#define ARRAY(member, condition)                       \
+    if (condition)                                     \
+    {                                                  \
+        memcpy(out, gb->member, sizeof(gb->member));   \
+        out += sizeof(gb->member);                     \
+    }
+#include "gb_state_fields.x"
+    return out - start;
+}
+
+__section__(".rare") static void __gb_state_fields_load(struct gb_s* gb, const uint8_t* in)
+{
+#define FIELD(member, bytes, condition)                \
+    if (condition)                                     \
+    {                                                  \
+        gb->member = __gb_state_get(&in, (bytes));     \
+    }
+#define ARRAY(member, condition)                       \
+    if (condition)                                     \
+    {                                                  \
+        memcpy(gb->member, in, sizeof(gb->member));    \
+        in += sizeof(gb->member);                      \
+    }
+#include "gb_state_fields.x"
+}
+
+// Identifies this build's in-memory layout of the gb struct, as far as the
+// state fields go: the checksum of the fields of a patterned struct.
+__section__(".rare") static uint32_t __gb_state_layout(void)
+{
+    static uint32_t layout;
+    if (layout)
+        return layout;
+
+    struct gb_s* probe = cb_malloc(sizeof(struct gb_s));
+    if (!probe)
+        return 0;
+
+    for (size_t i = 0; i < sizeof(struct gb_s); ++i)
+    {
+        ((uint8_t*)probe)[i] = (uint8_t)(i * 167 + 13);
+    }
+
+    uint8_t* fields = cb_malloc(__gb_state_fields_size(probe));
+    if (fields)
+    {
+        uint32_t size = __gb_state_fields_save(probe, fields);
+        layout = crc32_for_buffer(fields, size) ^ (uint32_t)offsetof(struct gb_s, audio);
+        layout += !layout;
+        cb_free(fields);
+    }
+
+    cb_free(probe);
+    return layout;
+}
+
+// largest possible output of gb_state_save()
+__section__(".rare") uint32_t gb_state_max_size(struct gb_s* gb)
+{
+    const uint32_t chunk_sizes[] = {
+        offsetof(struct gb_s, audio),
+        __gb_state_fields_size(gb),
+        ROM_HEADER_SIZE,
+        WRAM_SIZE,
+        VRAM_SIZE,
+        sizeof(xram),
+        gb->gb_cart_ram_size,
+        audio_get_state_size(),
+        MAX_BREAKPOINTS * sizeof(gb_breakpoint),
+    };
+
+    uint32_t size = sizeof(struct StateHeader);
+    for (int i = 0; i < PEANUT_GB_ARRAYSIZE(chunk_sizes); ++i)
+    {
+        size += sizeof(struct StateChunk) + LZ4_compressBound(chunk_sizes[i]);
+    }
+    return size;
+}
+
+// writes a chunk to out; returns the number of bytes written.
+__section__(".rare") static uint32_t __gb_state_save_chunk(
+    char* out, void* lz4_state, uint32_t type, const void* data, uint32_t size
+)
+{
+    struct StateChunk chunk = {.type = type, .size = size};
+    char* packed = out + sizeof(chunk);
+
+    int packed_size = LZ4_compress_fast_extState(
+        lz4_state, (const char*)data, packed, size, LZ4_compressBound(size), 1
+    );
+    if (packed_size <= 0 || (uint32_t)packed_size >= size)
+    {
+        memcpy(packed, data, size);
+        packed_size = size;
+    }
+
+    chunk.packed_size = packed_size;
+    chunk.crc32 = crc32_for_buffer((const unsigned char*)packed, packed_size);
+    memcpy(out, &chunk, sizeof(chunk));
+    return sizeof(chunk) + packed_size;
+}
+
+// out must hold gb_state_max_size() bytes. Returns the size of the state,
+// or 0 if out of memory.
+__section__(".rare") uint32_t gb_state_save(struct gb_s* gb, char* out)
+{
+    void* lz4_state = cb_malloc(LZ4_sizeofState());
+    void* apu = cb_malloc(audio_get_state_size());
+    uint8_t* fields = cb_malloc(__gb_state_fields_size(gb));
+    if (!lz4_state || !apu || !fields)
+    {
+        cb_free(lz4_state);
+        cb_free(apu);
+        cb_free(fields);
+        return 0;
+    }
+
+    const char* start = out;
+
+    // header
+    struct StateHeader header;
+    memset(&header, 0, sizeof(header));
+    CB_ASSERT(strlen(CB_SAVE_STATE_MAGIC) == sizeof(header.magic));
+    memcpy(header.magic, CB_SAVE_STATE_MAGIC, sizeof(header.magic));
+    header.version = CB_SAVE_STATE_VERSION;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    header.big_endian = 1;
+#else
+    header.big_endian = 0;
+#endif
+    header.bits = sizeof(void*);
+    header.layout = __gb_state_layout();
+    memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+
+    out += __gb_state_save_chunk(
+        out, lz4_state, CB_STATE_CHUNK_GB, gb, offsetof(struct gb_s, audio)
+    );
+    out += __gb_state_save_chunk(
+        out, lz4_state, CB_STATE_CHUNK_GB_FIELDS, fields, __gb_state_fields_save(gb, fields)
+    );
+    out += __gb_state_save_chunk(
+        out, lz4_state, CB_STATE_CHUNK_ROM_HEADER, gb->gb_rom + ROM_HEADER_START, ROM_HEADER_SIZE
+    );
+    out += __gb_state_save_chunk(out, lz4_state, CB_STATE_CHUNK_WRAM, gb->wram, WRAM_SIZE);
+    out += __gb_state_save_chunk(out, lz4_state, CB_STATE_CHUNK_VRAM, gb->vram, VRAM_SIZE);
+    out += __gb_state_save_chunk(out, lz4_state, CB_STATE_CHUNK_XRAM, xram, sizeof(xram));
+    if (gb->gb_cart_ram_size > 0)
+    {
+        out += __gb_state_save_chunk(
+            out, lz4_state, CB_STATE_CHUNK_CART_RAM, gb->gb_cart_ram, gb->gb_cart_ram_size
+        );
+    }
+
+    audio_state_save(&gb->audio, apu);
+    out +=
+        __gb_state_save_chunk(out, lz4_state, CB_STATE_CHUNK_APU, apu, audio_get_state_size());
+
+    out += __gb_state_save_chunk(
+        out, lz4_state, CB_STATE_CHUNK_BREAKPOINTS, gb->breakpoints,
+        MAX_BREAKPOINTS * sizeof(gb_breakpoint)
+    );
+
+    // intentionally skipped: lcd; bgcache; rom
+
+    cb_free(lz4_state);
+    cb_free(apu);
+    cb_free(fields);
+    return out - start;
+}
+
+// Finds the given chunk in a version 1 state's chunks, and checks that it
+// has the expected size and is undamaged; returns NULL otherwise.
+__section__(".rare") static const char* __gb_state_find_chunk(
+    const char* in, size_t size, uint32_t type, uint32_t expected_size
+)
+{
+    while (size >= sizeof(struct StateChunk))
+    {
+        struct StateChunk chunk;
+        memcpy(&chunk, in, sizeof(chunk));
+        if (chunk.packed_size > size - sizeof(chunk))
+            return NULL;
+
+        if (chunk.type == type)
+        {
+            const unsigned char* packed = (const unsigned char*)in + sizeof(chunk);
+            if (chunk.size != expected_size || chunk.packed_size > chunk.size ||
+                crc32_for_buffer(packed, chunk.packed_size) != chunk.crc32)
+            {
+                return NULL;
+            }
+            return in;
+        }
+
+        in += sizeof(chunk) + chunk.packed_size;
+        size -= sizeof(chunk) + chunk.packed_size;
+    }
+    return NULL;
+}
+
+// decompresses a chunk found by __gb_state_find_chunk() into out
+__section__(".rare") static bool __gb_state_unpack_chunk(const char* in, void* out)
+{
+    struct StateChunk chunk;
+    memcpy(&chunk, in, sizeof(chunk));
+    in += sizeof(chunk);
+
+    if (chunk.packed_size == chunk.size)
+    {
+        memcpy(out, in, chunk.size);
+        return true;
+    }
 
+    return LZ4_decompress_safe(in, out, chunk.packed_size, chunk.size) == chunk.size;
+}
+
+// loads the gb struct (up to the APU), except for the fields which belong
+// to this instance rather than to the state.
+__section__(".rare") static void __gb_state_load_struct(
+    struct gb_s* gb, const struct gb_s* in_gb
+)
+{
     void* preserved_fields[] = {
-        &gb->gb_rom,       &gb->wram,         &gb->vram,        &gb->gb_cart_ram,
-        &gb->breakpoints,  &gb->lcd,          &gb->direct.priv, &gb->gb_error,
-        &gb->gb_serial_tx, &gb->gb_serial_rx, &gb->gb_boot_rom,
+        &gb->gb_rom,       &gb->wram,         &gb->vram,          &gb->gb_cart_ram,
+        &gb->breakpoints,  &gb->lcd,          &gb->direct.priv,   &gb->gb_error,
+        &gb->gb_serial_tx, &gb->gb_serial_rx, &gb->gb_input_poll, &gb->gb_boot_rom,
 #if ENABLE_BGCACHE
         &gb->bgcache,
 #endif
@@ -5974,13 +6561,125 @@ __section__(".rare") const char* gb_state_load(struct gb_s* gb, const char* in,
         memcpy(preserved_data + i, preserved_fields[i], sizeof(void*));
     }
 
-    // gb struct
-    memcpy(gb, in_gb, sizeof(*gb));
+    memcpy(gb, in_gb, offsetof(struct gb_s, audio));
 
     for (int i = 0; i < PEANUT_GB_ARRAYSIZE(preserved_fields); ++i)
     {
         memcpy(preserved_fields[i], preserved_data + i, sizeof(void*));
     }
+}
+
+// once the state's memory has been loaded, loads the APU (or resets it, if
+// apu is NULL) and brings everything derived from the state up to date.
+__section__(".rare") static void __gb_state_loaded(struct gb_s* gb, const void* apu)
+{
+    gb_snapshot_dirty_all();
+
+    // clear caches and other presentation-layer data
+    memset(gb->lcd, 0, LCD_SIZE);
+#if ENABLE_BGCACHE
+    __gb_rebuild_bgcache(gb);
+#endif
+    __gb_update_selected_bank_addr(gb);
+    __gb_update_selected_cart_bank_addr(gb);
+
+    if (apu)
+    {
+        audio_state_load(&gb->audio, apu);
+    }
+    else
+    {
+        // (keeping the loaded registers, as the CPU sees them)
+        audio_init_from_regs(&gb->audio);
+    }
+    audio_sync(gb->audio_cycles);
+
+    // intentionally skipped: lcd; bgcache; rom
+
+    // update boot rom overlay state
+    if (gb->gb_bios_enable)
+    {
+        if (gb->gb_boot_rom)
+        {
+            memcpy(gb->gb_rom, gb->gb_boot_rom, 0x100);
+        }
+        else
+        {
+            // best we can do if boot rom is no longer available
+            gb_reset(gb);
+        }
+    }
+    else
+    {
+        memcpy(gb->gb_rom, gb_original_rom, 0x100);
+    }
+
+    gb_detect_interrupts(gb);
+}
+
+// copies the state fields from a version 0 state's gb struct
+__section__(".rare") static void __gb_state_load_v0_fields(
+    struct gb_s* gb, const struct gb_s_v0* in_gb
+)
+{
+#define FIELD(member, bytes, condition) \
+    if (condition)                      \
+    {                                   \
+        gb->member = in_gb->member;     \
+    }
+#define ARRAY(member, condition)                               \
+    if (condition)                                             \
+    {                                                          \
+        memcpy(gb->member, in_gb->member, sizeof(gb->member)); \
+    }
+#include "gb_state_fields.x"
+}
+
+// in and size exclude the header
+__section__(".rare") static const char* __gb_state_load_v0(
+    struct gb_s* gb, const char* in, size_t size
+)
+{
+    if (size < sizeof(struct gb_s_v0) + ROM_HEADER_SIZE)
+    {
+        return "State size too small";
+    }
+
+    const struct gb_s_v0* in_gb = (const struct gb_s_v0*)(const void*)in;
+    in += sizeof(*in_gb);
+    size_t state_size = __gb_state_v0_size(in_gb);
+
+    if (size + sizeof(struct StateHeader) != state_size)
+    {
+        return "State size mismatch";
+    }
+
+    if (gb->gb_cart_ram_size != in_gb->gb_cart_ram_size)
+    {
+        return "Cartridge RAM size mismatch";
+    }
+
+    const uint8_t* in_rom_header = (const uint8_t*)in;
+    const uint8_t* gb_rom_header = gb->gb_rom + ROM_HEADER_START;
+    if (memcmp(in_rom_header, gb_rom_header, 15))
+    {
+        return "State appears to be for a different ROM";
+    }
+    in += ROM_HEADER_SIZE;
+
+    // fields the old struct doesn't hold keep their current values
+    struct gb_s* loaded = cb_malloc(offsetof(struct gb_s, audio));
+    if (!loaded)
+    {
+        return "Not enough memory to load state";
+    }
+    memcpy(loaded, gb, offsetof(struct gb_s, audio));
+    __gb_state_load_v0_fields(loaded, in_gb);
+
+    // -- we're in the clear now --
+
+    __gb_state_load_struct(gb, loaded);
+    cb_free(loaded);
 
     // wram
     memcpy(gb->wram, in, WRAM_SIZE);
@@ -6007,40 +6706,631 @@ __section__(".rare") const char* gb_state_load(struct gb_s* gb, const char* in,
     // memcpy(gb->breakpoints, in, MAX_BREAKPOINTS * sizeof(gb_breakpoint));
     in += MAX_BREAKPOINTS * sizeof(gb_breakpoint);
 
-    // clear caches and other presentation-layer data
-    memset(gb->lcd, 0, LCD_SIZE);
+    // the APU's state was saved in an older form, so it's rebuilt from its registers
+    __gb_state_loaded(gb, NULL);
+    return NULL;
+}
+
+// in and size exclude the header. If not native, the state was saved by a
+// build with a different layout, and the gb struct is loaded from its
+// portable form instead.
+__section__(".rare") static const char* __gb_state_load_v1(
+    struct gb_s* gb, const char* in, size_t size, bool native
+)
+{
+    const uint32_t fields_size = __gb_state_fields_size(gb);
+    const char* chunk_gb =
+        native
+            ? __gb_state_find_chunk(in, size, CB_STATE_CHUNK_GB, offsetof(struct gb_s, audio))
+            : __gb_state_find_chunk(in, size, CB_STATE_CHUNK_GB_FIELDS, fields_size);
+    const char* chunk_rom_header =
+        __gb_state_find_chunk(in, size, CB_STATE_CHUNK_ROM_HEADER, ROM_HEADER_SIZE);
+    const char* chunk_wram = __gb_state_find_chunk(in, size, CB_STATE_CHUNK_WRAM, WRAM_SIZE);
+    const char* chunk_vram = __gb_state_find_chunk(in, size, CB_STATE_CHUNK_VRAM, VRAM_SIZE);
+    const char* chunk_apu =
+        native ? __gb_state_find_chunk(in, size, CB_STATE_CHUNK_APU, audio_get_state_size())
+               : in;
+    const char* chunk_cart_ram =
+        gb->gb_cart_ram_size > 0
+            ? __gb_state_find_chunk(in, size, CB_STATE_CHUNK_CART_RAM, gb->gb_cart_ram_size)
+            : in;
+
+    // (xram and breakpoints aren't loaded; see __gb_state_load_v0)
+
+    if (!chunk_gb || !chunk_rom_header || !chunk_wram || !chunk_vram || !chunk_apu ||
+        !chunk_cart_ram)
+    {
+        return "State is damaged or incomplete";
+    }
+
+    uint8_t in_rom_header[ROM_HEADER_SIZE];
+    if (!__gb_state_unpack_chunk(chunk_rom_header, in_rom_header))
+    {
+        return "State is damaged";
+    }
+    if (memcmp(in_rom_header, gb->gb_rom + ROM_HEADER_START, 15))
+    {
+        return "State appears to be for a different ROM";
+    }
+
+    // the gb struct and APU are small, and are checked before anything is
+    // loaded; the rest is decompressed straight into place.
+    const size_t gb_size = offsetof(struct gb_s, audio);
+    char* tmp = cb_malloc(gb_size + (native ? audio_get_state_size() : fields_size));
+    if (!tmp)
+    {
+        return "Not enough memory to load state";
+    }
+
+    struct gb_s* in_gb = (struct gb_s*)(void*)tmp;
+    const char* apu = native ? tmp + gb_size : NULL;
+    const char* error = NULL;
+
+    if (native)
+    {
+        if (!__gb_state_unpack_chunk(chunk_gb, tmp) ||
+            !__gb_state_unpack_chunk(chunk_apu, tmp + gb_size))
+        {
+            error = "State is damaged";
+        }
+    }
+    else if (!__gb_state_unpack_chunk(chunk_gb, tmp + gb_size))
+    {
+        error = "State is damaged";
+    }
+    else
+    {
+        // fields the portable form doesn't hold keep their current values
+        memcpy(in_gb, gb, gb_size);
+        __gb_state_fields_load(in_gb, (const uint8_t*)tmp + gb_size);
+    }
+
+    if (!error && gb->gb_cart_ram_size != in_gb->gb_cart_ram_size)
+    {
+        error = "Cartridge RAM size mismatch";
+    }
+
+    if (!error)
+    {
+        // -- we're in the clear now --
+        // (every chunk has been checksummed, so can't fail to decompress)
+
+        __gb_state_load_struct(gb, in_gb);
+        __gb_state_unpack_chunk(chunk_wram, gb->wram);
+        __gb_state_unpack_chunk(chunk_vram, gb->vram);
+        if (gb->gb_cart_ram_size > 0)
+        {
+            __gb_state_unpack_chunk(chunk_cart_ram, gb->gb_cart_ram);
+        }
+        __gb_state_loaded(gb, apu);
+    }
+
+    cb_free(tmp);
+    return error;
+}
+
+// returns NULL on success; error message otherwise
+// if failure, no change is made to gb.
+// Note: provided gb must already be initialized for the given ROM;
+// in particular, it needs to have a gb_cart_ram field init'd with the correct
+// size, and rom needs to be already loaded.
+__section__(".rare") const char* gb_state_load(struct gb_s* gb, const char* in, size_t size)
+{
+    // at least enough to read save header
+    if (size < sizeof(struct StateHeader))
+    {
+        return "State size too small";
+    }
+
+    struct StateHeader* header = (struct StateHeader*)in;
+    in += sizeof(struct StateHeader);
+    size -= sizeof(struct StateHeader);
+
+    if (strncmp(header->magic, CB_SAVE_STATE_MAGIC, sizeof(header->magic)))
+    {
+        return "Not a CrankBoy savestate";
+    }
+
+    if (header->version > CB_SAVE_STATE_VERSION)
+    {
+        return "State comes from an incompatible future version of CrankBoy";
+    }
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    if (!header->big_endian)
+#else
+    if (header->big_endian)
+#endif
+    {
+        return "State endianness incorrect";
+    }
+
+    // the gb struct is only loaded from its in-memory form if it was saved
+    // by a build with the same layout; older states have no portable form.
+    bool native = header->bits == sizeof(void*) &&
+                  (header->version < 2 || header->layout == __gb_state_layout());
+    if (!native && header->version < 2)
+    {
+        return "State 64-bit/32-bit mismatch (note: states from before version 2 "
+               "cannot be shared between Playdate and Simulator)";
+    }
+
+    if (header->version == 0)
+    {
+        return __gb_state_load_v0(gb, in, size);
+    }
+    return __gb_state_load_v1(gb, in, size, native);
+}
+
+/**
+ * In-memory snapshots, e.g. for run-ahead.
+ *
+ * Unlike save states, a snapshot is only valid for the gb_s it was taken
+ * from (pointers are copied verbatim) and is never validated, so it is
+ * cheap enough to take and restore every frame. Covers the gb struct,
+ * WRAM, VRAM, xram and cartridge RAM; the LCD is deliberately left alone.
+ * APU state is only included if requested, as bringing it up to date with
+ * the CPU costs a few frames' worth of synthesis.
+ */
+__section__(".text.cb") size_t gb_snapshot_size(const struct gb_s* gb)
+{
+    return sizeof(struct gb_s) + WRAM_SIZE + VRAM_SIZE + sizeof(xram) + gb->gb_cart_ram_size;
+}
+
+__section__(".text.cb") void gb_snapshot_save(const struct gb_s* gb, uint8_t* out, bool save_audio)
+{
+    memcpy(out, gb, offsetof(struct gb_s, audio));
+    if (save_audio)
+    {
+        audio_state_save(&gb->audio, out + offsetof(struct gb_s, audio));
+    }
+    out += sizeof(*gb);
+    memcpy(out, gb->wram, WRAM_SIZE);
+    out += WRAM_SIZE;
+    memcpy(out, gb->vram, VRAM_SIZE);
+    out += VRAM_SIZE;
+    memcpy(out, xram, sizeof(xram));
+    out += sizeof(xram);
+    if (gb->gb_cart_ram_size > 0)
+    {
+        memcpy(out, gb->gb_cart_ram, gb->gb_cart_ram_size);
+    }
+}
+
+// if restore_audio is false, APU state is left as-is; this is useful
+// if sound was disabled (direct.sound = 0) since the snapshot was taken,
+// as the audio callback may have advanced the APU in the meantime.
+__section__(".text.cb") void gb_snapshot_restore(
+    struct gb_s* gb, const uint8_t* in, bool restore_audio
+)
+{
+    const uint8_t bios_enable = gb->gb_bios_enable;
+
+    memcpy(gb, in, offsetof(struct gb_s, audio));
+    if (restore_audio)
+    {
+        audio_state_load(&gb->audio, in + offsetof(struct gb_s, audio));
+        audio_sync(gb->audio_cycles);
+    }
+    in += sizeof(*gb);
+    memcpy(gb->wram, in, WRAM_SIZE);
+    in += WRAM_SIZE;
+    memcpy(gb->vram, in, VRAM_SIZE);
+    in += VRAM_SIZE;
+    memcpy(xram, in, sizeof(xram));
+    in += sizeof(xram);
+    if (gb->gb_cart_ram_size > 0)
+    {
+        memcpy(gb->gb_cart_ram, in, gb->gb_cart_ram_size);
+    }
+    gb_snapshot_dirty_all();
+
+#if ENABLE_BGCACHE
+    __gb_rebuild_bgcache(gb);
+#endif
+
+    // boot rom overlay may have been unmapped since the snapshot
+    if (bios_enable != gb->gb_bios_enable)
+    {
+        memcpy(gb->gb_rom, gb->gb_bios_enable ? gb->gb_boot_rom : gb_original_rom, 0x100);
+    }
+}
+
+/**
+ * Snapshot deltas: cheap enough to take every frame, for run-ahead, rewind
+ * and quick-saves.
+ *
+ * A base is a buffer laid out as by gb_snapshot_save(), which the delta
+ * functions keep up to date by copying only the pages of WRAM, VRAM and
+ * cartridge RAM written since it was last brought up to date. The gb struct
+ * (except the APU) and xram are small and are always copied. Up to
+ * GB_SNAPSHOT_TRACKS bases can be maintained independently; each call takes
+ * the index of the base's track. A new base must first be filled with
+ * gb_snapshot_delta_reset() and gb_snapshot_delta_save().
+ *
+ * Like snapshots, deltas are only valid for the gb_s they were taken from.
+ */
+
+// number of pages of WRAM, VRAM and cartridge RAM
+__section__(".text.cb") static unsigned __gb_snapshot_pages(const struct gb_s* gb)
+{
+    return GB_SNAPSHOT_CRAM_PAGE +
+           (gb->gb_cart_ram_size + GB_SNAPSHOT_PAGE_SIZE - 1) / GB_SNAPSHOT_PAGE_SIZE;
+}
+
+// the given page of the emulator's memory
+__section__(".text.cb") static uint8_t* __gb_snapshot_page(struct gb_s* gb, unsigned page)
+{
+    if (page < GB_SNAPSHOT_VRAM_PAGE)
+        return gb->wram + (page - GB_SNAPSHOT_WRAM_PAGE) * GB_SNAPSHOT_PAGE_SIZE;
+    if (page < GB_SNAPSHOT_CRAM_PAGE)
+        return gb->vram + (page - GB_SNAPSHOT_VRAM_PAGE) * GB_SNAPSHOT_PAGE_SIZE;
+    return gb->gb_cart_ram + (page - GB_SNAPSHOT_CRAM_PAGE) * GB_SNAPSHOT_PAGE_SIZE;
+}
+
+// offset of the given page within a snapshot (gb_s, WRAM, VRAM, xram, cart RAM)
+__section__(".text.cb") static size_t __gb_snapshot_page_offset(unsigned page)
+{
+    size_t offset = sizeof(struct gb_s) + page * GB_SNAPSHOT_PAGE_SIZE;
+    return page >= GB_SNAPSHOT_CRAM_PAGE ? offset + sizeof(xram) : offset;
+}
+
+// copies a page back into the emulator's memory, invalidating whatever was
+// cached from it.
+__section__(".text.cb") static void __gb_snapshot_page_restore(
+    struct gb_s* gb, unsigned page, const uint8_t* in
+)
+{
+    uint8_t* out = __gb_snapshot_page(gb, page);
+
 #if ENABLE_BGCACHE
-    for (size_t i = 0; i < 0x800; ++i)
+    // Only the tiles and tilemap entries which actually differ are
+    // invalidated: each changed tile's data costs a scan of both tilemaps
+    // later, and run-ahead reverts every frame.
+    if (page >= GB_SNAPSHOT_VRAM_PAGE && page < GB_SNAPSHOT_CRAM_PAGE)
     {
-        __gb_update_bgcache_tile_data_deferred(gb, i);
+        unsigned offset = (page - GB_SNAPSHOT_VRAM_PAGE) * GB_SNAPSHOT_PAGE_SIZE;
+        if (offset < 0x1800)
+        {
+            for (unsigned i = 0; i < GB_SNAPSHOT_PAGE_SIZE; i += 16)
+            {
+                if (memcmp(out + i, in + i, 16) != 0)
+                {
+                    memcpy(out + i, in + i, 16);
+                    __gb_update_bgcache_tile_data_deferred(gb, (offset + i) / 16);
+                }
+            }
+        }
+        else
+        {
+            for (unsigned i = 0; i < GB_SNAPSHOT_PAGE_SIZE; ++i)
+            {
+                if (out[i] != in[i])
+                {
+                    unsigned tmidx = offset - 0x1800 + i;
+                    out[i] = in[i];
+                    __gb_update_bgcache_tile_deferred(gb, 0, tmidx, in[i]);
+                    __gb_update_bgcache_tile_deferred(gb, 1, tmidx, in[i]);
+                }
+            }
+        }
+        return;
     }
 #endif
-    __gb_update_selected_bank_addr(gb);
-    __gb_update_selected_cart_bank_addr(gb);
 
-    // intentionally skipped: lcd; bgcache; rom
+    memcpy(out, in, GB_SNAPSHOT_PAGE_SIZE);
+}
 
-    // update boot rom overlay state
-    if (gb->gb_bios_enable)
+// restores the gb struct (except the APU) and xram from a snapshot
+__section__(".text.cb") static void __gb_snapshot_restore_struct(
+    struct gb_s* gb, const uint8_t* in_gb, const uint8_t* in_xram
+)
+{
+    const uint8_t bios_enable = gb->gb_bios_enable;
+
+    memcpy(gb, in_gb, offsetof(struct gb_s, audio));
+    memcpy(xram, in_xram, sizeof(xram));
+
+    if (bios_enable != gb->gb_bios_enable)
     {
-        if (gb->gb_boot_rom)
+        memcpy(gb->gb_rom, gb->gb_bios_enable ? gb->gb_boot_rom : gb_original_rom, 0x100);
+    }
+}
+
+// marks every page as changed since the given track's base was last
+// brought up to date, so that the next gb_snapshot_delta_save() fills it.
+__section__(".text.cb") void gb_snapshot_delta_reset(unsigned track)
+{
+    const uint8_t bit = 1 << track;
+    for (unsigned i = 0; i < GB_SNAPSHOT_MAX_PAGES; ++i)
+    {
+        gb_dirty_pages[i] |= bit;
+    }
+}
+
+// size of a delta's header, gb struct, xram and index of the given number
+// of pages, before the pages' contents.
+#define GB_SNAPSHOT_DELTA_PAGES_OFFSET(count)                                   \
+    ((2 * sizeof(uint32_t) + offsetof(struct gb_s, audio) + sizeof(xram) + \
+      (count) * sizeof(uint16_t) + 3) &                                    \
+     ~(size_t)3)
+
+// largest possible output of gb_snapshot_delta_save()
+__section__(".text.cb") size_t gb_snapshot_delta_max_size(const struct gb_s* gb)
+{
+    const unsigned pages = __gb_snapshot_pages(gb);
+    return GB_SNAPSHOT_DELTA_PAGES_OFFSET(pages) + pages * GB_SNAPSHOT_PAGE_SIZE;
+}
+
+// out = a ^ b, for n bytes (any of which may alias)
+__section__(".text.cb") static void __gb_snapshot_xor(
+    uint8_t* out, const uint8_t* a, const uint8_t* b, size_t n
+)
+{
+    size_t i = 0;
+    for (; i + sizeof(uint32_t) <= n; i += sizeof(uint32_t))
+    {
+        uint32_t x, y;
+        memcpy(&x, a + i, sizeof(x));
+        memcpy(&y, b + i, sizeof(y));
+        x ^= y;
+        memcpy(out + i, &x, sizeof(x));
+    }
+    for (; i < n; ++i)
+    {
+        out[i] = a[i] ^ b[i];
+    }
+}
+
+__section__(".text.cb") static size_t __gb_snapshot_delta_save(
+    struct gb_s* gb, unsigned track, uint8_t* base, uint8_t* out, bool xor
+)
+{
+    const uint8_t bit = 1 << track;
+    const unsigned pages = __gb_snapshot_pages(gb);
+    uint8_t* base_xram = base ? base + sizeof(*gb) + WRAM_SIZE + VRAM_SIZE : NULL;
+    uint32_t count = 0;
+
+    if (out)
+    {
+        for (unsigned page = 0; page < pages; ++page)
         {
-            memcpy(gb->gb_rom, gb->gb_boot_rom, 0x100);
+            count += (gb_dirty_pages[page] & bit) != 0;
+        }
+    }
+
+    const size_t pages_offset = GB_SNAPSHOT_DELTA_PAGES_OFFSET(count);
+    const uint32_t header[2] = {pages_offset + count * GB_SNAPSHOT_PAGE_SIZE, count};
+    uint8_t* out_indices = NULL;
+    uint8_t* out_pages = NULL;
+
+    if (out)
+    {
+        uint8_t* out_gb = out + sizeof(header);
+        uint8_t* out_xram = out_gb + offsetof(struct gb_s, audio);
+
+        memcpy(out, header, sizeof(header));
+        if (xor)
+        {
+            __gb_snapshot_xor(out_gb, base, (const uint8_t*)gb, offsetof(struct gb_s, audio));
+            __gb_snapshot_xor(out_xram, base_xram, xram, sizeof(xram));
         }
         else
         {
-            // best we can do if boot rom is no longer available
-            gb_reset(gb);
+            memcpy(out_gb, gb, offsetof(struct gb_s, audio));
+            memcpy(out_xram, xram, sizeof(xram));
         }
+        out_indices = out_xram + sizeof(xram);
+        out_pages = out + pages_offset;
     }
-    else
+
+    if (base)
     {
-        memcpy(gb->gb_rom, gb_original_rom, 0x100);
+        memcpy(base, gb, offsetof(struct gb_s, audio));
+        memcpy(base_xram, xram, sizeof(xram));
     }
 
-    gb_detect_interrupts(gb);
+    for (unsigned page = 0; page < pages; ++page)
+    {
+        if likely (!(gb_dirty_pages[page] & bit))
+            continue;
 
-    return NULL;
+        gb_dirty_pages[page] &= ~bit;
+        const uint8_t* src = __gb_snapshot_page(gb, page);
+        uint8_t* base_page = base ? base + __gb_snapshot_page_offset(page) : NULL;
+        if (out)
+        {
+            const uint16_t index = page;
+            memcpy(out_indices, &index, sizeof(index));
+            if (xor)
+            {
+                __gb_snapshot_xor(out_pages, base_page, src, GB_SNAPSHOT_PAGE_SIZE);
+            }
+            else
+            {
+                memcpy(out_pages, src, GB_SNAPSHOT_PAGE_SIZE);
+            }
+            out_indices += sizeof(index);
+            out_pages += GB_SNAPSHOT_PAGE_SIZE;
+        }
+        if (base)
+        {
+            memcpy(base_page, src, GB_SNAPSHOT_PAGE_SIZE);
+        }
+    }
+
+    return out ? header[0] : 0;
+}
+
+// Brings the track's base (if non-NULL) up to date, and writes the changes
+// since it was last brought up to date to out (if non-NULL), which must
+// hold gb_snapshot_delta_max_size() bytes. Returns the size of the delta.
+//
+// A delta is laid out as: its size and page count (uint32_t each); the gb
+// struct up to the APU; xram; the pages' indices (uint16_t each); and,
+// 4-byte aligned, the pages' contents.
+__section__(".text.cb") size_t gb_snapshot_delta_save(
+    struct gb_s* gb, unsigned track, uint8_t* base, uint8_t* out
+)
+{
+    return __gb_snapshot_delta_save(gb, track, base, out, false);
+}
+
+// Like gb_snapshot_delta_save(), but the delta holds the changes XORed with
+// the base's previous contents (so unchanged bytes are zero, and compress
+// well), and can be undone with gb_snapshot_delta_unxor(). The base is
+// required.
+__section__(".text.cb") size_t gb_snapshot_delta_save_xor(
+    struct gb_s* gb, unsigned track, uint8_t* base, uint8_t* out
+)
+{
+    return __gb_snapshot_delta_save(gb, track, base, out, true);
+}
+
+// Undoes the most recent delta from gb_snapshot_delta_save_xor(), stepping
+// both the emulator and the track's base back to the state before it. The
+// emulator must match the base (i.e. nothing has run since the delta was
+// saved, or since the last gb_snapshot_revert()); the APU is left as-is.
+__section__(".text.cb") void gb_snapshot_delta_unxor(
+    struct gb_s* gb, unsigned track, uint8_t* base, const uint8_t* in
+)
+{
+    const uint8_t bit = 1 << track;
+    uint8_t* base_xram = base + sizeof(*gb) + WRAM_SIZE + VRAM_SIZE;
+
+    uint32_t header[2];
+    memcpy(header, in, sizeof(header));
+    const uint32_t count = header[1];
+
+    const uint8_t* in_gb = in + sizeof(header);
+    const uint8_t* in_xram = in_gb + offsetof(struct gb_s, audio);
+    const uint8_t* in_indices = in_xram + sizeof(xram);
+    const uint8_t* in_pages = in + GB_SNAPSHOT_DELTA_PAGES_OFFSET(count);
+
+    __gb_snapshot_xor(base, base, in_gb, offsetof(struct gb_s, audio));
+    __gb_snapshot_xor(base_xram, base_xram, in_xram, sizeof(xram));
+    __gb_snapshot_restore_struct(gb, base, base_xram);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint16_t page;
+        memcpy(&page, in_indices + i * sizeof(page), sizeof(page));
+
+        uint8_t* base_page = base + __gb_snapshot_page_offset(page);
+        __gb_snapshot_xor(
+            base_page, base_page, in_pages + i * GB_SNAPSHOT_PAGE_SIZE, GB_SNAPSHOT_PAGE_SIZE
+        );
+        __gb_snapshot_page_restore(gb, page, base_page);
+
+        // the page now differs from the other tracks' bases instead
+        gb_dirty_pages[page] = 0xFF & ~bit;
+    }
+}
+
+// Drops the most recent delta from gb_snapshot_delta_save_xor() (e.g. one
+// that couldn't be stored): steps only the track's base back to the state
+// before it, and marks its pages as changed again, so that the next delta
+// covers them as well. The emulator is left as-is.
+__section__(".text.cb") void gb_snapshot_delta_discard(
+    struct gb_s* gb, unsigned track, uint8_t* base, const uint8_t* in
+)
+{
+    const uint8_t bit = 1 << track;
+    uint8_t* base_xram = base + sizeof(*gb) + WRAM_SIZE + VRAM_SIZE;
+
+    uint32_t header[2];
+    memcpy(header, in, sizeof(header));
+    const uint32_t count = header[1];
+
+    const uint8_t* in_gb = in + sizeof(header);
+    const uint8_t* in_xram = in_gb + offsetof(struct gb_s, audio);
+    const uint8_t* in_indices = in_xram + sizeof(xram);
+    const uint8_t* in_pages = in + GB_SNAPSHOT_DELTA_PAGES_OFFSET(count);
+
+    __gb_snapshot_xor(base, base, in_gb, offsetof(struct gb_s, audio));
+    __gb_snapshot_xor(base_xram, base_xram, in_xram, sizeof(xram));
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint16_t page;
+        memcpy(&page, in_indices + i * sizeof(page), sizeof(page));
+
+        uint8_t* base_page = base + __gb_snapshot_page_offset(page);
+        __gb_snapshot_xor(
+            base_page, base_page, in_pages + i * GB_SNAPSHOT_PAGE_SIZE, GB_SNAPSHOT_PAGE_SIZE
+        );
+        gb_dirty_pages[page] |= bit;
+    }
+}
+
+// Applies a delta from gb_snapshot_delta_save() in place. Every track's base
+// is then considered out of date for the pages the delta holds.
+__section__(".text.cb") void gb_snapshot_delta_restore(struct gb_s* gb, const uint8_t* in)
+{
+    uint32_t header[2];
+    memcpy(header, in, sizeof(header));
+    const uint32_t count = header[1];
+
+    const uint8_t* in_gb = in + sizeof(header);
+    const uint8_t* in_xram = in_gb + offsetof(struct gb_s, audio);
+    const uint8_t* in_indices = in_xram + sizeof(xram);
+    const uint8_t* in_pages = in + GB_SNAPSHOT_DELTA_PAGES_OFFSET(count);
+
+    __gb_snapshot_restore_struct(gb, in_gb, in_xram);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint16_t page;
+        memcpy(&page, in_indices + i * sizeof(page), sizeof(page));
+        __gb_snapshot_page_restore(gb, page, in_pages + i * GB_SNAPSHOT_PAGE_SIZE);
+        __gb_mark_dirty(page);
+    }
+}
+
+// Restores the track's base in place, copying back only the pages written
+// since it was last brought up to date. Unlike gb_snapshot_restore(), the
+// APU is always left as-is.
+__section__(".text.cb") void gb_snapshot_revert(
+    struct gb_s* gb, unsigned track, const uint8_t* base
+)
+{
+    const uint8_t bit = 1 << track;
+    const unsigned pages = __gb_snapshot_pages(gb);
+
+    __gb_snapshot_restore_struct(gb, base, base + sizeof(*gb) + WRAM_SIZE + VRAM_SIZE);
+
+    for (unsigned page = 0; page < pages; ++page)
+    {
+        if likely (!(gb_dirty_pages[page] & bit))
+            continue;
+
+        __gb_snapshot_page_restore(gb, page, base + __gb_snapshot_page_offset(page));
+
+        // the page now differs from the other tracks' bases instead
+        gb_dirty_pages[page] = 0xFF & ~bit;
+    }
+}
+
+// Returns the next page of cartridge RAM, from the given one on, written
+// since the track was last brought up to date, and brings it up to date
+// (e.g. for saving cartridge RAM incrementally); -1 if there are none.
+__section__(".text.cb") int gb_cart_ram_next_dirty_page(
+    const struct gb_s* gb, unsigned track, int page
+)
+{
+    const uint8_t bit = 1 << track;
+    const int pages = (gb->gb_cart_ram_size + GB_SNAPSHOT_PAGE_SIZE - 1) / GB_SNAPSHOT_PAGE_SIZE;
+
+    for (; page < pages; ++page)
+    {
+        uint8_t* dirty = &gb_dirty_pages[GB_SNAPSHOT_CRAM_PAGE + page];
+        if (*dirty & bit)
+        {
+            *dirty &= ~bit;
+            return page;
+        }
+    }
+    return -1;
 }
 
 /**
@@ -6077,6 +7367,15 @@ void gb_init_serial(
     gb->gb_serial_rx = gb_serial_rx;
 }
 
+/**
+ * Set the function used to refresh the joypad state when the guest first
+ * reads P1 in a frame. Takes effect only while direct.late_input is set.
+ */
+void gb_init_input_poll(struct gb_s* gb, void (*gb_input_poll)(struct gb_s*))
+{
+    gb->gb_input_poll = gb_input_poll;
+}
+
 /**
  * Provides the emulator with the 256-byte boot ROM data.
  */
@@ -6114,6 +7413,8 @@ __section__(".rare") void gb_reset(struct gb_s* gb)
     gb->rtc_latch_s1 = 0;
     memset(gb->latched_rtc, 0, sizeof(gb->latched_rtc));
 
+    memset(&gb->lag, 0, sizeof(gb->lag));
+
     /* Initialise MBC7 values. */
     if (gb->mbc == 7)
     {
@@ -6212,6 +7513,10 @@ __section__(".rare") void gb_reset(struct gb_s* gb)
 
     memset(gb->vram, 0x00, VRAM_SIZE);
     memset(gb->wram, 0x00, WRAM_SIZE);
+    gb_snapshot_dirty_all();
+#if ENABLE_BGCACHE
+    __gb_rebuild_bgcache(gb);
+#endif
 }
 
 /**
@@ -6287,6 +7592,8 @@ __section__(".rare") enum gb_init_error_e gb_init(
      * automatically. */
     gb->gb_serial_tx = NULL;
     gb->gb_serial_rx = NULL;
+    gb->gb_input_poll = NULL;
+    gb->direct.late_input = 0;
 
     /* Check valid ROM using checksum value. */
     {
@@ -0,0 +1,139 @@
+/**
+ * Host benchmark for the APU (libs/minigb_apu). Drives it with the same
+ * randomised register traffic each run and times the audio callback, in ms
+ * per second of audio. See run.sh.
+ *
+ * usage: apu_bench <sound_mode> <sample_rate> [seconds] [runs]
+ *   sound_mode and sample_rate are the preference values (1: Fast,
+ *   2: Accurate; 0: 44.1 kHz .. 3: 11.025 kHz). If MONO is set in the
+ *   environment, NR51 always routes every channel to both sides.
+ */
+
+#include "stubs.h"
+
+#include <stdio.h>
+#include <time.h>
+
+int preferences_sound_mode = 1, preferences_sample_rate = 0, preferences_sound_render = 0;
+
+static struct gb_s gb;
+static uint32_t now;
+static bool mono;
+
+// output samples per callback, as on device
+#define CALLBACK_LEN 256
+
+#define FRAME_CYCLES 70224
+#define CLOCK_FREQ 4194304
+#define OUTPUT_RATE 44100
+
+// how far the emulation is kept ahead of the callback
+#define FRAMES_AHEAD 2
+
+static void w(uint16_t addr, uint8_t val)
+{
+    audio_write(&gb.audio, addr, val, now);
+}
+
+// a few writes of the kinds games make, at random points in the frame
+static void frame_writes(uint32_t frame_start)
+{
+    for (int k = 0; k < 8; k++)
+    {
+        now = frame_start + (rand() % FRAME_CYCLES);
+        switch (rand() % 12)
+        {
+        case 0: w(0xFF12, 0xF3); w(0xFF11, 0x80); w(0xFF13, rand()); w(0xFF14, 0x87); break;
+        case 1: w(0xFF17, 0xA5); w(0xFF16, 0x40); w(0xFF18, rand()); w(0xFF19, 0xC6); break;
+        case 2:
+            w(0xFF1A, 0x80); w(0xFF1C, 0x20 * (1 + rand() % 3)); w(0xFF1D, rand());
+            w(0xFF1E, 0x85);
+            break;
+        case 3: w(0xFF21, 0xF2); w(0xFF22, rand()); w(0xFF23, 0x80); break;
+        case 4: w(0xFF30 + rand() % 16, rand()); break;
+        case 5: w(0xFF10, 0x16); w(0xFF14, 0x86); break;
+        case 6: w(0xFF25, mono ? 0xFF : rand()); break;
+        case 7: w(0xFF24, 0x77); break;
+        case 8: w(0xFF21, 0x1F); w(0xFF23, 0xC0); w(0xFF20, 0x20); break;
+        default: break;
+        }
+    }
+}
+
+static double cpu_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Times each callback, keeping the least time seen for it over the runs: the
+// work is the same each run, so this filters out preemption and other noise.
+static void run(int seconds, double* times, uint32_t* checksum)
+{
+    static CB_GameScene scene;
+    CB_GameScene* scene_ptr = &scene;
+    static int16_t left[CALLBACK_LEN], right[CALLBACK_LEN];
+
+    srand(1);
+    audio_init(&gb.audio);
+    audio_enabled = 1;
+    audio_sync(0);
+
+    // the emulation runs whole frames, kept ahead of the callback
+    const long samples = (long)seconds * OUTPUT_RATE;
+    uint64_t frame = 0;
+    uint32_t sum = 0;
+
+    for (long done = 0, n = 0; done < samples; done += CALLBACK_LEN, ++n)
+    {
+        const uint64_t played = (uint64_t)(done + CALLBACK_LEN) * CLOCK_FREQ / OUTPUT_RATE;
+        while (frame <= played + FRAMES_AHEAD * FRAME_CYCLES)
+        {
+            frame_writes((uint32_t)frame);
+            frame += FRAME_CYCLES;
+            audio_sync((uint32_t)frame);
+        }
+
+        double start = cpu_seconds();
+        audio_callback(&scene_ptr, left, right, CALLBACK_LEN);
+        double spent = cpu_seconds() - start;
+        times[n] = spent < times[n] ? spent : times[n];
+
+        for (int i = 0; i < CALLBACK_LEN; ++i)
+            sum = sum * 31 + (uint16_t)left[i] * 7 + (uint16_t)right[i];
+    }
+
+    *checksum = sum;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <sound_mode> <sample_rate> [seconds] [runs]\n", argv[0]);
+        return 1;
+    }
+    preferences_sound_mode = atoi(argv[1]);
+    preferences_sample_rate = atoi(argv[2]);
+    int seconds = argc > 3 ? atoi(argv[3]) : 100;
+    int runs = argc > 4 ? atoi(argv[4]) : 5;
+    mono = getenv("MONO") != NULL;
+
+    const long callbacks = ((long)seconds * OUTPUT_RATE + CALLBACK_LEN - 1) / CALLBACK_LEN;
+    double* times = malloc(callbacks * sizeof(double));
+    for (long n = 0; n < callbacks; ++n)
+        times[n] = 1e9;
+
+    uint32_t checksum = 0;
+    for (int i = 0; i < runs; ++i)
+        run(seconds, times, &checksum);
+
+    double total = 0;
+    for (long n = 0; n < callbacks; ++n)
+        total += times[n];
+    free(times);
+
+    printf("%.3f ms/s (output checksum %08x)\n", total * 1000.0 / seconds, (unsigned)checksum);
+    return 0;
+}
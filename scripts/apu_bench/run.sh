@@ -0,0 +1,59 @@
+#!/bin/sh
+# Builds the APU benchmark against libs/minigb_apu as of each given git
+# revision ("." for the working tree, the default) and times each sound mode
+# and sample rate, in ms per second of audio. The builds take turns,
+# and each keeps its best round, so that revisions can be compared on a
+# noisy machine. Host timings only: compare revisions, not absolute figures.
+#
+# usage: scripts/apu_bench/run.sh [revision...]
+# environment: ROUNDS (default 5), SECONDS_OF_AUDIO per round (default 200)
+
+set -e
+cd "$(dirname "$0")/../.."
+ROUNDS="${ROUNDS:-5}"
+SECONDS_OF_AUDIO="${SECONDS_OF_AUDIO:-200}"
+OUT="$(mktemp -d)"
+trap 'rm -rf "$OUT"' EXIT
+
+[ $# -gt 0 ] || set -- .
+
+fetch()
+{
+    if [ "$1" = . ]; then cat "libs/minigb_apu/$2"; else git show "$1:libs/minigb_apu/$2"; fi
+}
+
+i=0
+for rev in "$@"; do
+    i=$((i + 1))
+    mkdir "$OUT/$i"
+    # the APU's own includes reach into the emulator and the app; stubs.h
+    # stands in for them
+    fetch "$rev" minigb_apu.c | sed -e 's|#include "../peanut_gb.h"|#include "stubs.h"|' \
+        -e '/#include "..\/src/d' > "$OUT/$i/minigb_apu.c"
+    fetch "$rev" minigb_apu.h > "$OUT/$i/minigb_apu.h"
+    cp scripts/apu_bench/stubs.h "$OUT/$i/"
+    ${CC:-cc} -O2 -std=gnu11 -w -I "$OUT/$i" -o "$OUT/$i/apu_bench" \
+        "$OUT/$i/minigb_apu.c" scripts/apu_bench/apu_bench.c -lm
+done
+
+for mode in 1 2; do
+    for rate in 0 1 2 3; do
+        round=0
+        while [ $round -lt "$ROUNDS" ]; do
+            round=$((round + 1))
+            j=0
+            for rev in "$@"; do
+                j=$((j + 1))
+                "$OUT/$j/apu_bench" $mode $rate "$SECONDS_OF_AUDIO" 3 | cut -d' ' -f1 >> "$OUT/$j.$mode.$rate"
+            done
+        done
+
+        printf "mode %s rate %s:" $mode $rate
+        j=0
+        for rev in "$@"; do
+            j=$((j + 1))
+            printf "  %s %s" "$rev" "$(sort -n "$OUT/$j.$mode.$rate" | head -n 1)"
+        done
+        echo
+    done
+done
@@ -0,0 +1,29 @@
+/**
+ * Just enough of the emulator and the app for minigb_apu.c to build on the
+ * host, standing in for its includes (see run.sh).
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "minigb_apu.h"
+
+// (audio_mem() finds the registers the CPU sees in hram, next to the APU)
+struct gb_s
+{
+    uint8_t hram[0x100];
+    audio_data audio;
+};
+
+typedef struct
+{
+    bool audioLocked;
+} CB_GameScene;
+
+extern int preferences_sound_mode, preferences_sample_rate, preferences_sound_render;
+
+#define DTCM_VERIFY_DEBUG()
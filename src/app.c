@@ -436,6 +436,74 @@ __section__(".rare") static void switchToPendingScene(void)
     }
 }
 
+#if CAP_FRAME_RATE
+// Waits until the next frame deadline. Deadlines are spaced exactly one
+// interval apart in absolute time, so time lost or gained on one frame is
+// made up on the next instead of accumulating. Time before the deadline is
+// first offered to the scene's slack hook; only what's left is spun away.
+__section__(".text.main") static void CB_pace_frame(float dt, float refreshRate)
+{
+    CB_FramePacer* pacer = &CB_App->pacer;
+
+    if (refreshRate <= 0)
+    {
+        pacer->interval = 0;
+        return;
+    }
+
+    float interval = 1.0f / refreshRate;
+
+    // elapsed time was reset dt seconds after the previous deadline's epoch
+    float deadline = pacer->deadline - dt + interval;
+
+    // resynchronize if the rate changed, or if we are more than a whole frame
+    // behind (e.g. after a load screen); don't try to win that time back.
+    if (interval != pacer->interval || deadline <= 0 || deadline > 2 * interval)
+    {
+        deadline = interval;
+    }
+    pacer->interval = interval;
+
+    float now = playdate->system->getElapsedTime();
+
+    if (now > deadline)
+    {
+        float late = now - deadline;
+        pacer->misses++;
+        pacer->window_misses++;
+        if (late > pacer->window_worst_late)
+            pacer->window_worst_late = late;
+    }
+    else
+    {
+        CB_Scene* scene = CB_App->scene;
+        if (scene && scene->slack)
+        {
+            while (deadline - now > FRAME_PACER_SLACK_MARGIN &&
+                   scene->slack(scene->managedObject, deadline - now - FRAME_PACER_SLACK_MARGIN))
+            {
+                now = playdate->system->getElapsedTime();
+            }
+        }
+
+        while (playdate->system->getElapsedTime() < deadline)
+            ;
+    }
+
+    pacer->deadline = deadline;
+    pacer->frames++;
+
+    if (++pacer->window_frames >= FRAME_PACER_WINDOW)
+    {
+        pacer->miss_rate = pacer->window_misses / (float)pacer->window_frames;
+        pacer->worst_late = pacer->window_worst_late;
+        pacer->window_frames = 0;
+        pacer->window_misses = 0;
+        pacer->window_worst_late = 0;
+    }
+}
+#endif
+
 __section__(".text.main") void CB_update(float dt)
 {
     CB_App->dt = dt;
@@ -490,13 +558,7 @@ __section__(".text.main") void CB_update(float dt)
     }
 
 #if CAP_FRAME_RATE
-    // cap frame rate
-    if (refreshRate > 0)
-    {
-        float refreshInterval = 1.0f / refreshRate;
-        while (playdate->system->getElapsedTime() < refreshInterval)
-            ;
-    }
+    CB_pace_frame(dt, refreshRate);
 #endif
 
 #endif
@@ -39,6 +39,12 @@ extern pthread_mutex_t audio_mutex;
 
 #define FPS_AVG_DECAY 0.8f
 
+// frame pacer statistics are published once per this many frames
+#define FRAME_PACER_WINDOW 60
+
+// don't hand slack to the scene if less than this much time (s) remains
+#define FRAME_PACER_SLACK_MARGIN 0.002f
+
 #define TENDENCY_BASED_ADAPTIVE_INTERLACING 1
 
 typedef struct
@@ -82,6 +88,27 @@ typedef struct
     bool has_mask;
 } CB_CoverCacheEntry;
 
+typedef struct
+{
+    // next deadline, measured from the most recent resetElapsedTime().
+    // Deadlines accumulate in whole intervals so that per-frame jitter
+    // does not drift the frame rate.
+    float deadline;
+    float interval;
+
+    uint32_t frames;
+    uint32_t misses;
+
+    // running totals for the current window
+    uint16_t window_frames;
+    uint16_t window_misses;
+    float window_worst_late;
+
+    // published at the end of each window
+    float miss_rate;   // fraction of deadlines missed
+    float worst_late;  // seconds past the deadline, worst case
+} CB_FramePacer;
+
 typedef struct CB_Application
 {
     float dt;
@@ -119,6 +146,8 @@ typedef struct CB_Application
     // - no per-game/global settings distinction
     // - some settings become inaccessible
     char* bundled_rom;
+
+    CB_FramePacer pacer;
 } CB_Application;
 
 extern CB_Application* CB_App;
@@ -21,11 +21,23 @@
 #define CRANK_MODE_TURBO_CW 1
 #define CRANK_MODE_TURBO_CCW 2
 #define CRANK_MODE_OFF 3
+#define CRANK_MODE_FAST_FORWARD 4
+#define CRANK_MODE_REWIND 5
+
+// overclock values at or above this adapt automatically;
+// OVERCLOCK_AUTO is capped at x2, OVERCLOCK_AUTO + 1 at x4.
+#define OVERCLOCK_AUTO 3
 
 #define PREF_BUTTON_NONE 0
 #define PREF_BUTTON_START 1
 #define PREF_BUTTON_SELECT 2
 
+// SUSPEND_ON leaves out games with battery-backed save data, as save
+// states do (see [7700] in game_scene.h); SUSPEND_ALL includes them.
+#define SUSPEND_OFF 0
+#define SUSPEND_ON 1
+#define SUSPEND_ALL 2
+
 #define DISPLAY_NAME_MODE_SHORT 0
 #define DISPLAY_NAME_MODE_DETAILED 1
 #define DISPLAY_NAME_MODE_FILENAME 2
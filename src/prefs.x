@@ -6,6 +6,7 @@ PREF(save_state_slot, 0)  // (note: has two corresponding settings)
 // audio
 PREF(sound_mode, 2)
 PREF(sample_rate, (pd_rev == PD_REV_A) ? 1 : 0)
+PREF(sound_render, 0)  // 0: in the audio callback; 1: by the emulation, per frame
 
 // display
 PREF(frame_skip, true)
@@ -21,6 +22,9 @@ PREF(crank_mode, CRANK_MODE_START_SELECT)
 PREF(crank_undock_button, PREF_BUTTON_NONE)
 PREF(crank_dock_button, PREF_BUTTON_NONE)
 PREF(overclock, 0)
+PREF(run_ahead, 0)  // number of hidden frames
+PREF(late_input, 0)
+PREF(suspend, SUSPEND_ON)  // resume where the game was left
 PREF(bios, !(CB_App->bundled_rom))
 PREF(script_support, !!(CB_App->bundled_rom))
 PREF(script_has_prompted, false)  // (not a real setting)
@@ -28,6 +28,11 @@ typedef struct CB_Scene
     void (*menu)(void* object);
     void (*free)(void* object);
     void (*event)(void* object, PDSystemEvent event, uint32_t arg);
+
+    // optional; invoked on the main stack while the frame pacer waits for
+    // the next deadline. Should do one small unit of deferred work and
+    // return true, or return false if there is nothing left to do.
+    bool (*slack)(void* object, float remaining);
 } CB_Scene;
 
 CB_Scene* CB_Scene_new(void);
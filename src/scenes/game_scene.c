@@ -9,6 +9,7 @@
 #define CB_IMPL
 #include "game_scene.h"
 
+#include "../../libs/lz4/lz4.h"
 #include "../../libs/minigb_apu/minigb_apu.h"
 #include "../../libs/peanut_gb.h"
 #include "../app.h"
@@ -50,10 +51,253 @@
 #define INTERLACE_LOCK_DURATION_MAX 60
 #define INTERLACE_LOCK_DURATION_MIN 1
 
+// --- Parameters for crank fast-forward ---
+
+// Upper bound on emulated frames per displayed frame while fast-forwarding.
+#define FAST_FORWARD_MAX 8
+
+// Crank degrees per update which add one to the fast-forward multiplier.
+#define FAST_FORWARD_DEGREES_PER_STEP 10.0f
+
+// Per-frame decay of the fast-forward multiplier once the crank slows down.
+#define FAST_FORWARD_DECAY 0.9f
+
+// --- Parameters for crank rewind ---
+
+// Memory set aside for rewind history (compressed deltas and keyframes).
+#define REWIND_BUDGET (1536 * 1024)
+
+// Frames between keyframes in the rewind history.
+#define REWIND_KEYFRAME_INTERVAL 120
+
+// Crank degrees per update (turned backwards) which count as rewinding.
+#define REWIND_DEGREES_PER_UPDATE 2.0f
+
+// Updates to keep rewinding for after the crank stops, so that an uneven
+// turn doesn't stutter.
+#define REWIND_HOLD_UPDATES 3
+
+// Snapshot delta tracks (see gb_snapshot_delta_save), one per snapshot base.
+#define SNAPSHOT_TRACK_RUN_AHEAD 0
+#define SNAPSHOT_TRACK_REWIND 1
+#define SNAPSHOT_TRACK_SRAM 2
+
 // Enables console logging for the dirty line update mechanism.
 // WARNING: Performance-intensive. Use for debugging only.
 #define LOG_DIRTY_LINES 0
 
+/**
+ * Rewind history: a ring of REWIND_BUDGET bytes holding an entry for each
+ * emulated frame, from which the oldest are evicted to make room. Each entry
+ * holds the LZ4-compressed XOR delta from the previous frame's state (see
+ * gb_snapshot_delta_save_xor) and, every REWIND_KEYFRAME_INTERVAL frames,
+ * the complete state as well.
+ *
+ * The base always holds the current state. Stepping back undoes the newest
+ * delta against it; keyframes are restored on the way past, so that anything
+ * which changed memory behind the dirty tracking's back is put right.
+ */
+typedef struct CB_Rewind
+{
+    uint8_t* ring;
+    uint32_t head;    // end of the newest entry
+    uint32_t tail;    // start of the oldest entry
+    uint32_t end;     // end of the oldest entries, while wrapped
+    uint32_t newest;  // start of the newest entry
+    uint32_t frames;  // number of entries
+    bool wrapped;     // entries run from tail to end, then from 0 to head
+
+    uint8_t* base;     // snapshot of the current state
+    uint8_t* scratch;  // uncompressed delta
+    void* lz4_state;
+    unsigned since_keyframe;
+
+    // compressed bytes and time (s) per captured frame, averaged
+    float bytes_per_frame;
+    float capture_cost;
+} CB_Rewind;
+
+typedef struct
+{
+    uint32_t prev;  // start of the previous entry
+    uint32_t delta_size;
+    uint32_t keyframe_size;  // 0 if none
+    // followed by the compressed delta, then keyframe
+} CB_RewindEntry;
+
+/**
+ * Save states are captured in full (compressed, along with the top of the
+ * LCD for the thumbnail) as soon as they're requested, then written out in
+ * the background a bounded step at a time: one step per frame, plus as many
+ * as fit in the frame pacer's slack time. Saves requested meanwhile are
+ * queued behind it, in order; a save to a slot already waiting in the queue
+ * replaces that one. The user is told if a save fails to be written.
+ */
+
+// steps of a save job, in order
+#define SAVE_JOB_OPEN 0
+#define SAVE_JOB_WRITE 1
+#define SAVE_JOB_COMMIT 2
+#define SAVE_JOB_THUMBNAIL 3
+#define SAVE_JOB_INDEX 4
+
+// bytes of the state written to disk per step
+#define SAVE_JOB_WRITE_SLICE 4096
+
+typedef struct CB_SaveJob
+{
+    struct CB_SaveJob* next;  // in the queue
+
+    unsigned slot;
+    int step;
+    bool failed;
+
+    char* buff;
+    uint32_t size;
+    uint32_t written;
+    SDFile* file;
+
+    // top of the LCD when the state was captured; NULL if not yet drawn
+    uint8_t* lcd;
+
+    // frames spent writing, and the longest frame and step (s) meanwhile
+    unsigned frames;
+    float worst_dt;
+    float worst_step;
+
+    // slowest recent step (s), for fitting steps into the slack (see slack_fits)
+    float slack_step;
+} CB_SaveJob;
+
+/**
+ * Save state slot index: one file per game beside its states, holding each
+ * slot's timestamp, size, checksum and script flag along with its thumbnail
+ * (LZ4-compressed), so that the slot picker reads one file rather than every
+ * slot's .state and .thumb. It's read when the game scene is created, kept
+ * in memory, and rewritten after each save state is written.
+ *
+ * The picker trusts the index; a slot is only checked against its .state file
+ * when it's loaded, and re-derived from the .state and .thumb files if the
+ * file is gone or doesn't match its checksum. If the index is missing or
+ * damaged, every slot is re-derived, one per slack-time step (or sooner, when
+ * the picker asks for it).
+ */
+
+#define STATE_INDEX_MAGIC 0x58494243  // "CBIX"
+#define STATE_INDEX_VERSION 1
+
+#define STATE_THUMBNAIL_SIZE (SAVE_STATE_THUMBNAIL_H * ((SAVE_STATE_THUMBNAIL_W + 7) / 8))
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    uint32_t crc;  // of everything that follows
+} CB_StateIndexHeader;
+
+typedef struct
+{
+    uint32_t size;  // of the .state file (0: empty slot)
+    uint32_t crc;   // of the .state file
+    uint32_t mtime;  // of the .state file, as an epoch
+    uint32_t timestamp;
+    uint16_t thumbnail_size;  // as stored (0: none; STATE_THUMBNAIL_SIZE: uncompressed)
+    uint8_t script;
+    uint8_t reserved;
+} CB_StateIndexEntry;
+
+// (in the file, the header and entries are followed by each slot's thumbnail)
+typedef struct CB_StateIndex
+{
+    CB_StateIndexEntry entries[SAVE_STATE_SLOT_COUNT];
+    uint8_t* thumbnails[SAVE_STATE_SLOT_COUNT];
+    // (runtime only) slots not yet re-derived from their files, while the
+    // index file is missing or damaged
+    uint16_t unchecked;
+    bool valid;  // entries came from the file (unchecked ones are not just blank)
+    bool dirty;  // entries changed since the file was written
+    float worst_check;
+} CB_StateIndex;
+
+/**
+ * Suspend state: an ordinary save state, written beside the slots when the
+ * game is left (for the library, or on exit or lock) and restored as soon as
+ * it's next launched. Like save states, it's only used for a cartridge with
+ * a battery if the user opts in, with a warning (SUSPEND_ALL). Then cart RAM
+ * is saved first and its checksum recorded, and the suspend state is only
+ * restored over matching save data, so it can never roll the save data back.
+ * With the setting off, any suspend state left over is deleted on leaving.
+ */
+
+#define SUSPEND_MAGIC 0x53534243  // "CBSS"
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t sram_crc;  // of cart RAM, as saved alongside (0: no battery)
+    uint32_t size;      // of the state which follows
+    uint32_t crc;       // of the state
+} CB_SuspendHeader;
+
+/**
+ * Cart RAM is saved incrementally: rather than rewriting the whole .sav file,
+ * the pages written since the last save (see gb_cart_ram_next_dirty_page)
+ * are appended to a journal beside it, along with the RTC and save time, a
+ * bounded step at a time like save states. Loading replays the journal over
+ * the .sav file, so the .sav file itself keeps its format.
+ *
+ * The journal is only replayed over the .sav file it was started against
+ * (by checksum), and only up to the first torn or damaged record. Once it
+ * would outgrow the cart RAM, or anything about it is in doubt, the .sav file
+ * is written in full instead and the journal discarded ("compaction").
+ */
+
+#define SRAM_JOURNAL_MAGIC 0x4C4A4243  // "CBJL"
+
+// record page holding the RTC and save time instead of cart RAM
+#define SRAM_JOURNAL_RTC 0xFFFF
+
+// bytes of records appended to the journal per step
+#define SRAM_JOURNAL_WRITE_SLICE 4096
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t base_crc;  // of the cart RAM in the .sav file
+} CB_SramJournalHeader;
+
+typedef struct
+{
+    uint32_t crc;  // of the rest of the record, including the data
+    uint16_t page;
+    uint16_t size;
+    // followed by the data
+} CB_SramJournalRecord;
+
+typedef struct CB_SramJournal
+{
+    uint32_t base_crc;
+    bool base_valid;  // the .sav file holds the cart RAM checksummed above
+    bool compact;     // write the .sav file in full next time
+    uint32_t size;    // bytes in the journal file (0: none)
+
+    // records being appended, or (if pending_compact) the .sav file being
+    // written in full, to a .tmp file, and the checksum of its cart RAM
+    uint8_t* pending;
+    uint32_t pending_size;
+    uint32_t pending_written;
+    bool pending_compact;
+    uint32_t pending_crc;
+    SDFile* file;
+
+    // slowest recent time (s) to start a save, and to do one step of it;
+    // work is only done in the frame pacer's slack if it would fit (see
+    // slack_fits)
+    float worst_begin;
+    float worst_step;
+} CB_SramJournal;
+
 CB_GameScene* audioGameScene = NULL;
 
 static void CB_GameScene_selector_init(CB_GameScene* gameScene);
@@ -62,6 +306,15 @@ static void CB_GameScene_menu(void* object);
 static void CB_GameScene_generateBitmask(void);
 static void CB_GameScene_free(void* object);
 static void CB_GameScene_event(void* object, PDSystemEvent event, uint32_t arg);
+static bool CB_GameScene_slack(void* object, float remaining);
+static void CB_GameScene_poll_input(struct gb_s* gb);
+static void save_job_advance(CB_GameScene* gameScene);
+static void save_job_flush(CB_GameScene* gameScene);
+static void state_index_load(CB_GameScene* gameScene);
+static void state_index_check_next(CB_GameScene* gameScene);
+static bool suspend_state_enabled(CB_GameScene* gameScene);
+static void suspend_state_write(CB_GameScene* gameScene);
+static bool suspend_state_resume(CB_GameScene* gameScene);
 
 static uint8_t* read_rom_to_ram(
     const char* filename, CB_GameSceneError* sceneError, size_t* o_rom_size
@@ -74,7 +327,7 @@ static uint8_t* read_rom_to_ram(
 static int read_cart_ram_file(
     const char* save_filename, struct gb_s* gb, unsigned int* last_save_time
 );
-static void write_cart_ram_file(const char* save_filename, struct gb_s* gb);
+static bool write_cart_ram_file(const char* save_filename, struct gb_s* gb);
 
 static void gb_error(struct gb_s* gb, const enum gb_error_e gb_err, const uint16_t val);
 static void gb_save_to_disk(struct gb_s* gb);
@@ -238,6 +491,41 @@ char* cb_game_config_path(const char* rom_filename)
 
 static LCDBitmap* numbers_bmp = NULL;
 static uint32_t last_fps_digits;
+static uint32_t last_pacer_digits;
+static uint32_t last_run_ahead_digits;
+static uint32_t last_rewind_cost_digits;
+static uint32_t last_rewind_rate_digits;
+static uint32_t last_audio_latency_digits;
+static uint32_t last_audio_resync_digits;
+
+// set when SRAM is idle and dirty, so the save can happen in frame slack time
+static bool sram_flush_pending;
+
+// if no slack time arrives within this many frames, save immediately
+#define SRAM_FLUSH_SLACK_GRACE 60
+
+// Work is only done in the frame pacer's slack if its slowest step so far
+// would fit. That estimate eases down by this factor with each new step, and
+// each time the work is passed over, so that one slow step (an SD card
+// stall, say) doesn't keep the work out of the slack for good.
+#define SLACK_WORST_DECAY 0.95f
+
+// records how long a step of slack-time work took
+static void slack_worst_update(float* worst, float start)
+{
+    *worst = CB_MAX(*worst * SLACK_WORST_DECAY, playdate->system->getElapsedTime() - start);
+}
+
+// true if work whose steps are estimated to take *worst (s) fits in the slack
+static bool slack_fits(float* worst, float remaining)
+{
+    if (remaining > *worst)
+        return true;
+
+    *worst *= SLACK_WORST_DECAY;
+    return false;
+}
+
 static uint8_t fps_draw_timer;
 
 CB_GameScene* CB_GameScene_new(const char* rom_filename, char* name_short)
@@ -252,6 +540,8 @@ CB_GameScene* CB_GameScene_new(const char* rom_filename, char* name_short)
         numbers_bmp = playdate->graphics->loadBitmap("fonts/numbers", NULL);
     }
 
+    sram_flush_pending = false;
+
     if (!DTCM_VERIFY_DEBUG())
         return NULL;
 
@@ -274,6 +564,7 @@ CB_GameScene* CB_GameScene_new(const char* rom_filename, char* name_short)
     scene->menu = CB_GameScene_menu;
     scene->free = CB_GameScene_free;
     scene->event = CB_GameScene_event;
+    scene->slack = CB_GameScene_slack;
     scene->use_user_stack = 0;  // user stack is slower
 
     scene->preferredRefreshRate = 30;
@@ -298,6 +589,8 @@ CB_GameScene* CB_GameScene_new(const char* rom_filename, char* name_short)
     gameScene->previous_joypad_state = 0xFF;
 
     gameScene->crank_turbo_accumulator = 0.0f;
+    gameScene->fast_forward_level = 1.0f;
+    gameScene->fast_forward_achieved = 1.0f;
     gameScene->crank_turbo_a_active = false;
     gameScene->crank_turbo_b_active = false;
     gameScene->crank_was_docked = playdate->system->isCrankDocked();
@@ -402,7 +695,7 @@ CB_GameScene* CB_GameScene_new(const char* rom_filename, char* name_short)
 
     if (CB_App->soundSource == NULL)
     {
-        CB_App->soundSource = playdate->sound->addSource(audio_callback, &audioGameScene, 0);
+        CB_App->soundSource = playdate->sound->addSource(audio_callback, &audioGameScene, 1);
     }
     audio_enabled = 1;
     context->gb = gb;
@@ -438,6 +731,7 @@ CB_GameScene* CB_GameScene_new(const char* rom_filename, char* name_short)
         enum gb_init_error_e gb_ret = gb_init(
             context->gb, context->wram, context->vram, lcd, rom, rom_size, gb_error, context
         );
+        gb_init_input_poll(context->gb, CB_GameScene_poll_input);
 
         if (CB_App->bootRomData && preferences_bios)
         {
@@ -627,6 +921,17 @@ CB_GameScene* CB_GameScene_new(const char* rom_filename, char* name_short)
 #endif
     DTCM_VERIFY();
 
+    if (gameScene->save_states_supported && gameScene->state == CB_GameSceneStateLoaded)
+    {
+        call_with_main_stack_1(state_index_load, gameScene);
+    }
+
+    if (suspend_state_enabled(gameScene) && gameScene->save_data_loaded_successfully &&
+        gameScene->state == CB_GameSceneStateLoaded)
+    {
+        call_with_main_stack_1(suspend_state_resume, gameScene);
+    }
+
     CB_ASSERT(gameScene->context == context);
     CB_ASSERT(gameScene->context->scene == gameScene);
     CB_ASSERT(gameScene->context->gb->direct.priv == context);
@@ -781,6 +1086,128 @@ static uint8_t* read_rom_to_ram(
     return rom;
 }
 
+// Returns the save filename with its .sav extension (if any) replaced by the
+// given one, e.g. ".tmp"; the caller frees it.
+static char* save_sibling_filename(const char* save_filename, const char* extension)
+{
+    size_t len = strlen(save_filename);
+    char* filename = cb_malloc(len + strlen(extension) + 1);
+    if (!filename)
+    {
+        return NULL;
+    }
+
+    strcpy(filename, save_filename);
+
+    char* ext = strrchr(filename, '.');
+    if (ext && strcmp(ext, ".sav") == 0)
+    {
+        strcpy(ext, extension);
+    }
+    else
+    {
+        strcat(filename, extension);
+    }
+    return filename;
+}
+
+// (of a record with the given data size, from the page on)
+static uint32_t sram_journal_record_crc(const uint8_t* record, uint16_t size)
+{
+    const size_t from = offsetof(CB_SramJournalRecord, page);
+    return crc32_for_buffer(record + from, sizeof(CB_SramJournalRecord) - from + size);
+}
+
+// Marks all of cart RAM as saved.
+static void sram_journal_clean(struct gb_s* gb)
+{
+    for (int page = 0; (page = gb_cart_ram_next_dirty_page(gb, SNAPSHOT_TRACK_SRAM, page)) >= 0;
+         ++page)
+        ;
+}
+
+// Replays the journal over the cart RAM just read from the .sav file.
+// Returns true if it held the RTC and save time.
+static bool sram_journal_replay(
+    CB_GameScene* gameScene, struct gb_s* gb, unsigned int* last_save_time
+)
+{
+    CB_SramJournal* journal = gameScene->sram_journal;
+
+    char* journal_filename = save_sibling_filename(gameScene->save_filename, ".jnl");
+    if (!journal_filename)
+    {
+        journal->compact = true;
+        return false;
+    }
+    SDFile* f = playdate->file->open(journal_filename, kFileReadData);
+    cb_free(journal_filename);
+    if (f == NULL)
+    {
+        return false;
+    }
+
+    CB_SramJournalHeader header;
+    if (playdate->file->read(f, &header, sizeof(header)) != sizeof(header) ||
+        header.magic != SRAM_JOURNAL_MAGIC || header.base_crc != journal->base_crc)
+    {
+        // left over from an interrupted compaction, or damaged
+        playdate->system->logToConsole("Ignoring save journal (does not match save file)");
+        playdate->file->close(f);
+        journal->compact = true;
+        return false;
+    }
+
+    union
+    {
+        CB_SramJournalRecord record;
+        uint8_t bytes[sizeof(CB_SramJournalRecord) + GB_SNAPSHOT_PAGE_SIZE];
+    } buff;
+    CB_SramJournalRecord* record = &buff.record;
+    uint8_t* data = buff.bytes + sizeof(*record);
+
+    bool has_rtc = false;
+    unsigned records = 0;
+    uint32_t size = sizeof(header);
+    int read;
+    while ((read = playdate->file->read(f, record, sizeof(*record))) != 0)
+    {
+        if (read != sizeof(*record) || record->size > GB_SNAPSHOT_PAGE_SIZE ||
+            playdate->file->read(f, data, record->size) != record->size ||
+            sram_journal_record_crc(buff.bytes, record->size) != record->crc)
+        {
+            // torn (or damaged); anything appended after it would be lost
+            playdate->system->logToConsole("Save journal truncated after %u records", records);
+            journal->compact = true;
+            break;
+        }
+
+        if (record->page == SRAM_JOURNAL_RTC)
+        {
+            if (record->size == sizeof(gb->cart_rtc) + sizeof(unsigned int))
+            {
+                memcpy(gb->cart_rtc, data, sizeof(gb->cart_rtc));
+                memcpy(last_save_time, data + sizeof(gb->cart_rtc), sizeof(unsigned int));
+                has_rtc = true;
+            }
+        }
+        else if ((uint32_t)record->page * GB_SNAPSHOT_PAGE_SIZE + record->size <=
+                 gb->gb_cart_ram_size)
+        {
+            memcpy(gb->gb_cart_ram + record->page * GB_SNAPSHOT_PAGE_SIZE, data, record->size);
+        }
+
+        size += sizeof(*record) + record->size;
+        records++;
+    }
+
+    playdate->file->close(f);
+    journal->size = size;
+
+    playdate->system->logToConsole("Replayed %u save journal records", records);
+    return has_rtc;
+}
+
 static int read_cart_ram_file(
     const char* save_filename, struct gb_s* gb, unsigned int* last_save_time
 )
@@ -799,6 +1226,12 @@ static int read_cart_ram_file(
     }
     gb->gb_cart_ram_size = sram_len;
 
+    if (sram_len > 0 && gameScene->cartridge_has_battery && !gameScene->sram_journal)
+    {
+        gameScene->sram_journal = cb_calloc(1, sizeof(CB_SramJournal));
+    }
+    sram_journal_clean(gb);
+
     SDFile* f = playdate->file->open(save_filename, kFileReadData);
     if (f == NULL)
     {
@@ -831,26 +1264,84 @@ static int read_cart_ram_file(
     }
 
     playdate->file->close(f);
+
+    if (gameScene->sram_journal)
+    {
+        gameScene->sram_journal->base_crc = crc32_for_buffer(gb->gb_cart_ram, sram_len);
+        gameScene->sram_journal->base_valid = true;
+
+        if (sram_journal_replay(gameScene, gb, last_save_time))
+        {
+            code = 2;
+        }
+    }
+
     return code;
 }
 
-static void write_cart_ram_file(const char* save_filename, struct gb_s* gb)
+// Replaces the save file with the temporary one just written, keeping the
+// old one as a backup. Returns true if successful.
+static bool commit_cart_ram_file(
+    const char* save_filename, const char* tmp_filename, const char* bak_filename
+)
+{
+    // Verify that the temporary file is not zero-bytes
+    FileStat stat;
+    if (playdate->file->stat(tmp_filename, &stat) != 0)
+    {
+        playdate->system->logToConsole(
+            "Error: Failed to stat temp save file %s. Aborting save.", tmp_filename
+        );
+        playdate->file->unlink(tmp_filename, false);
+        return false;
+    }
+
+    if (stat.size == 0)
+    {
+        playdate->system->logToConsole(
+            "Error: Wrote 0-byte temp save file %s. Aborting and deleting.", tmp_filename
+        );
+        playdate->file->unlink(tmp_filename, false);
+        return false;
+    }
+
+    // Rename files: .sav -> .bak, then .tmp -> .sav
+    playdate->system->logToConsole("Save successful, renaming files.");
+
+    playdate->file->unlink(bak_filename, false);
+    playdate->file->rename(save_filename, bak_filename);
+
+    if (playdate->file->rename(tmp_filename, save_filename) != 0)
+    {
+        playdate->system->logToConsole(
+            "CRITICAL: Failed to rename temp file to save file. Restoring "
+            "backup."
+        );
+        playdate->file->rename(bak_filename, save_filename);
+        return false;
+    }
+
+    return true;
+}
+
+// Returns true if the save file was written.
+static bool write_cart_ram_file(const char* save_filename, struct gb_s* gb)
 {
     // Get the size of the save RAM from the gb context.
     const size_t sram_len = gb_get_save_size(gb);
     CB_GameSceneContext* context = gb->direct.priv;
     CB_GameScene* gameScene = context->scene;
+    bool success = false;
 
     // If there is no battery, exit.
     if (!gameScene->cartridge_has_battery)
     {
-        return;
+        return false;
     }
 
     // Generate .tmp and .bak filenames
-    size_t len = strlen(save_filename);
-    char* tmp_filename = cb_malloc(len + 2);
-    char* bak_filename = cb_malloc(len + 2);
+    char* tmp_filename = save_sibling_filename(save_filename, ".tmp");
+    char* bak_filename = save_sibling_filename(save_filename, ".bak");
 
     if (!tmp_filename || !bak_filename)
     {
@@ -858,29 +1349,6 @@ static void write_cart_ram_file(const char* save_filename, struct gb_s* gb)
         goto cleanup;
     }
 
-    strcpy(tmp_filename, save_filename);
-    strcpy(bak_filename, save_filename);
-
-    char* ext_tmp = strrchr(tmp_filename, '.');
-    if (ext_tmp && strcmp(ext_tmp, ".sav") == 0)
-    {
-        strcpy(ext_tmp, ".tmp");
-    }
-    else
-    {
-        strcat(tmp_filename, ".tmp");
-    }
-
-    char* ext_bak = strrchr(bak_filename, '.');
-    if (ext_bak && strcmp(ext_bak, ".sav") == 0)
-    {
-        strcpy(ext_bak, ".bak");
-    }
-    else
-    {
-        strcat(bak_filename, ".bak");
-    }
-
     playdate->file->unlink(tmp_filename, false);
 
     // Write data to the temporary file
@@ -909,78 +1377,338 @@ static void write_cart_ram_file(const char* save_filename, struct gb_s* gb)
 
     playdate->file->close(f);
 
-    // Verify that the temporary file is not zero-bytes
-    FileStat stat;
-    if (playdate->file->stat(tmp_filename, &stat) != 0)
-    {
-        playdate->system->logToConsole(
-            "Error: Failed to stat temp save file %s. Aborting save.", tmp_filename
-        );
-        playdate->file->unlink(tmp_filename, false);
-        goto cleanup;
-    }
-
-    if (stat.size == 0)
-    {
-        playdate->system->logToConsole(
-            "Error: Wrote 0-byte temp save file %s. Aborting and deleting.", tmp_filename
-        );
-        playdate->file->unlink(tmp_filename, false);
-        goto cleanup;
-    }
-
-    // Rename files: .sav -> .bak, then .tmp -> .sav
-    playdate->system->logToConsole("Save successful, renaming files.");
-
-    playdate->file->unlink(bak_filename, false);
-    playdate->file->rename(save_filename, bak_filename);
-
-    if (playdate->file->rename(tmp_filename, save_filename) != 0)
-    {
-        playdate->system->logToConsole(
-            "CRITICAL: Failed to rename temp file to save file. Restoring "
-            "backup."
-        );
-        playdate->file->rename(bak_filename, save_filename);
-    }
+    success = commit_cart_ram_file(save_filename, tmp_filename, bak_filename);
 
 cleanup:
     if (tmp_filename)
         cb_free(tmp_filename);
     if (bak_filename)
         cb_free(bak_filename);
+    return success;
 }
 
-static void gb_save_to_disk_(struct gb_s* gb)
+// Drops the records being appended to the journal, and makes sure the next
+// save writes the .sav file in full.
+static void sram_save_abort(CB_GameScene* gameScene)
 {
-    DTCM_VERIFY_DEBUG();
-
-    CB_GameSceneContext* context = gb->direct.priv;
-    CB_GameScene* gameScene = context->scene;
+    CB_SramJournal* journal = gameScene->sram_journal;
 
-    if (gameScene->isCurrentlySaving)
+    if (journal->file)
     {
-        playdate->system->logToConsole("Save to disk skipped: another save is in progress.");
-        return;
+        playdate->file->close(journal->file);
+        journal->file = NULL;
     }
+    cb_free(journal->pending);
+    journal->pending = NULL;
+    journal->pending_compact = false;
+    journal->compact = true;
+    gameScene->context->gb->direct.sram_dirty = true;
+}
 
-    if (!context->gb->direct.sram_dirty)
+// Once the .sav file holds the cart RAM with the given checksum, discards
+// the journal.
+static void sram_save_compacted(CB_GameScene* gameScene, uint32_t crc)
+{
+    CB_SramJournal* journal = gameScene->sram_journal;
+
+    char* journal_filename = save_sibling_filename(gameScene->save_filename, ".jnl");
+    if (journal_filename)
     {
-        return;
+        playdate->file->unlink(journal_filename, false);
+        cb_free(journal_filename);
     }
 
-    gameScene->isCurrentlySaving = true;
+    journal->base_crc = crc;
+    journal->base_valid = true;
+    journal->compact = false;
+    journal->size = 0;
+}
 
-    if (gameScene->save_filename)
+// Appends the next slice of the pending records to the journal, or writes
+// the next slice of the .sav file. Returns true while there's more to do.
+static bool sram_save_step_(CB_GameScene* gameScene)
+{
+    CB_SramJournal* journal = gameScene->sram_journal;
+    if (!journal || !journal->pending)
     {
-        write_cart_ram_file(gameScene->save_filename, context->gb);
+        return false;
     }
-    else
+
+    if (!journal->file)
     {
-        playdate->system->logToConsole("No save file name specified; can't save.");
+        char* filename = save_sibling_filename(
+            gameScene->save_filename, journal->pending_compact ? ".tmp" : ".jnl"
+        );
+        if (filename)
+        {
+            if (journal->pending_compact || journal->size == 0)
+            {
+                playdate->file->unlink(filename, false);
+            }
+            journal->file =
+                playdate->file->open(filename, journal->pending_compact ? kFileWrite : kFileAppend);
+            cb_free(filename);
+        }
+        if (!journal->file)
+        {
+            playdate->system->logToConsole("Error: Can't open save file for writing.");
+            sram_save_abort(gameScene);
+            return false;
+        }
+        return true;
     }
 
-    context->gb->direct.sram_dirty = false;
+    int slice =
+        CB_MIN(SRAM_JOURNAL_WRITE_SLICE, journal->pending_size - journal->pending_written);
+    if (playdate->file->write(
+            journal->file, journal->pending + journal->pending_written, slice
+        ) != slice)
+    {
+        playdate->system->logToConsole("Error: Failed to write save data.");
+        sram_save_abort(gameScene);
+        return false;
+    }
+
+    if (journal->pending_compact)
+    {
+        // (the checksum covers the cart RAM, which the file starts with)
+        uint32_t sram_len = gameScene->context->gb->gb_cart_ram_size;
+        if (journal->pending_written < sram_len)
+        {
+            journal->pending_crc = crc32_continue(
+                journal->pending_crc, journal->pending + journal->pending_written,
+                CB_MIN(slice, sram_len - journal->pending_written)
+            );
+        }
+    }
+
+    journal->pending_written += slice;
+    if (journal->pending_written < journal->pending_size)
+    {
+        return true;
+    }
+
+    if (playdate->file->close(journal->file) != 0)
+    {
+        journal->file = NULL;
+        playdate->system->logToConsole("Error: Failed to close save file.");
+        sram_save_abort(gameScene);
+        return false;
+    }
+    journal->file = NULL;
+    cb_free(journal->pending);
+    journal->pending = NULL;
+
+    if (!journal->pending_compact)
+    {
+        journal->size += journal->pending_size;
+        return false;
+    }
+
+    journal->pending_compact = false;
+    char* tmp_filename = save_sibling_filename(gameScene->save_filename, ".tmp");
+    char* bak_filename = save_sibling_filename(gameScene->save_filename, ".bak");
+    if (tmp_filename && bak_filename &&
+        commit_cart_ram_file(gameScene->save_filename, tmp_filename, bak_filename))
+    {
+        sram_save_compacted(gameScene, journal->pending_crc);
+    }
+    else
+    {
+        sram_save_abort(gameScene);
+    }
+    cb_free(tmp_filename);
+    cb_free(bak_filename);
+    return false;
+}
+
+static bool sram_save_step(CB_GameScene* gameScene)
+{
+    CB_SramJournal* journal = gameScene->sram_journal;
+    if (!journal || !journal->pending)
+    {
+        return false;
+    }
+
+    float start = playdate->system->getElapsedTime();
+    bool more = sram_save_step_(gameScene);
+    slack_worst_update(&journal->worst_step, start);
+    return more;
+}
+
+static void sram_save_finish(CB_GameScene* gameScene)
+{
+    while (sram_save_step(gameScene))
+        ;
+}
+
+// Starts writing the .sav file in full (see sram_save_step), after which the
+// journal is discarded.
+static void sram_save_compact(CB_GameScene* gameScene, struct gb_s* gb)
+{
+    CB_SramJournal* journal = gameScene->sram_journal;
+    const uint32_t sram_len = gb->gb_cart_ram_size;
+    unsigned int now = playdate->system->getSecondsSinceEpoch(NULL);
+
+    uint8_t* pending =
+        journal ? cb_malloc(sram_len + sizeof(gb->cart_rtc) + sizeof(now)) : NULL;
+    if (!pending)
+    {
+        // (all at once, then)
+        if (!write_cart_ram_file(gameScene->save_filename, gb))
+        {
+            if (journal)
+            {
+                journal->compact = true;
+            }
+            gb->direct.sram_dirty = true;
+        }
+        else if (journal)
+        {
+            sram_save_compacted(gameScene, crc32_for_buffer(gb->gb_cart_ram, sram_len));
+            sram_journal_clean(gb);
+        }
+        return;
+    }
+
+    // the same layout as write_cart_ram_file
+    gameScene->last_save_time = now;
+    memcpy(pending, gb->gb_cart_ram, sram_len);
+    memcpy(pending + sram_len, gb->cart_rtc, sizeof(gb->cart_rtc));
+    memcpy(pending + sram_len + sizeof(gb->cart_rtc), &now, sizeof(now));
+    sram_journal_clean(gb);
+
+    playdate->system->logToConsole("Writing save file in full");
+
+    journal->pending = pending;
+    journal->pending_size = sram_len + sizeof(gb->cart_rtc) + sizeof(now);
+    journal->pending_written = 0;
+    journal->pending_compact = true;
+    journal->pending_crc = 0;
+}
+
+// Writes a journal record to out; returns its size.
+static uint32_t sram_journal_record(uint8_t* out, uint16_t page, const void* data, uint16_t size)
+{
+    CB_SramJournalRecord record = {0, page, size};
+    memcpy(out, &record, sizeof(record));
+    memcpy(out + sizeof(record), data, size);
+
+    record.crc = sram_journal_record_crc(out, size);
+    memcpy(out, &record.crc, sizeof(record.crc));
+    return sizeof(record) + size;
+}
+
+// Starts saving cart RAM: gathers the pages written since the last save into
+// records to append to the journal (see sram_save_step), or else compacts.
+static void sram_save_begin(CB_GameScene* gameScene, struct gb_s* gb)
+{
+    CB_SramJournal* journal = gameScene->sram_journal;
+
+    sram_save_finish(gameScene);
+
+    if (!journal || !journal->base_valid || journal->compact)
+    {
+        sram_save_compact(gameScene, gb);
+        return;
+    }
+
+    const uint32_t sram_len = gb->gb_cart_ram_size;
+    const uint32_t pages = (sram_len + GB_SNAPSHOT_PAGE_SIZE - 1) / GB_SNAPSHOT_PAGE_SIZE;
+    uint8_t rtc[sizeof(gb->cart_rtc) + sizeof(unsigned int)];
+
+    uint8_t* pending = cb_malloc(
+        sizeof(CB_SramJournalHeader) + (pages + 1) * sizeof(CB_SramJournalRecord) + sram_len +
+        sizeof(rtc)
+    );
+    if (!pending)
+    {
+        sram_save_compact(gameScene, gb);
+        return;
+    }
+
+    uint32_t size = 0;
+    if (journal->size == 0)
+    {
+        CB_SramJournalHeader header = {SRAM_JOURNAL_MAGIC, journal->base_crc};
+        memcpy(pending, &header, sizeof(header));
+        size = sizeof(header);
+    }
+
+    unsigned records = 0;
+    for (int page = 0; (page = gb_cart_ram_next_dirty_page(gb, SNAPSHOT_TRACK_SRAM, page)) >= 0;
+         ++page)
+    {
+        uint32_t offset = page * GB_SNAPSHOT_PAGE_SIZE;
+        size += sram_journal_record(
+            pending + size, page, gb->gb_cart_ram + offset,
+            CB_MIN(GB_SNAPSHOT_PAGE_SIZE, sram_len - offset)
+        );
+        records++;
+    }
+
+    unsigned int now = playdate->system->getSecondsSinceEpoch(NULL);
+    gameScene->last_save_time = now;
+    memcpy(rtc, gb->cart_rtc, sizeof(gb->cart_rtc));
+    memcpy(rtc + sizeof(gb->cart_rtc), &now, sizeof(now));
+    size += sram_journal_record(pending + size, SRAM_JOURNAL_RTC, rtc, sizeof(rtc));
+
+    if (journal->size + size > sram_len)
+    {
+        cb_free(pending);
+        sram_save_compact(gameScene, gb);
+        return;
+    }
+
+    playdate->system->logToConsole("Journaling %u pages of save data", records);
+
+    journal->pending = pending;
+    journal->pending_size = size;
+    journal->pending_written = 0;
+}
+
+// If wait is false, returns once saving has started; the rest is done by
+// sram_save_step.
+static void gb_save_to_disk_(struct gb_s* gb, bool wait)
+{
+    DTCM_VERIFY_DEBUG();
+
+    CB_GameSceneContext* context = gb->direct.priv;
+    CB_GameScene* gameScene = context->scene;
+
+    if (gameScene->isCurrentlySaving)
+    {
+        playdate->system->logToConsole("Save to disk skipped: another save is in progress.");
+        return;
+    }
+
+    if (wait)
+    {
+        sram_save_finish(gameScene);
+    }
+
+    if (!context->gb->direct.sram_dirty)
+    {
+        return;
+    }
+
+    gameScene->isCurrentlySaving = true;
+
+    // (set again if the save fails)
+    context->gb->direct.sram_dirty = false;
+
+    if (gameScene->save_filename)
+    {
+        sram_save_begin(gameScene, context->gb);
+        if (wait)
+        {
+            sram_save_finish(gameScene);
+        }
+    }
+    else
+    {
+        playdate->system->logToConsole("No save file name specified; can't save.");
+    }
 
     gameScene->isCurrentlySaving = false;
 
@@ -989,7 +1717,31 @@ static void gb_save_to_disk_(struct gb_s* gb)
 
 static void gb_save_to_disk(struct gb_s* gb)
 {
-    call_with_main_stack_1(gb_save_to_disk_, gb);
+    call_with_main_stack_2(gb_save_to_disk_, gb, true);
+}
+
+static void gb_save_to_disk_async(struct gb_s* gb)
+{
+    call_with_main_stack_2(gb_save_to_disk_, gb, false);
+}
+
+// Saves cart RAM, folding the journal into the .sav file, e.g. on exit: the
+// .sav file alone is then up to date, for anyone copying it off the device
+// or running a build without the journal.
+static void gb_save_to_disk_compact(struct gb_s* gb)
+{
+    CB_GameSceneContext* context = gb->direct.priv;
+    CB_SramJournal* journal = context->scene->sram_journal;
+
+    // (records still being appended count too, unless it's being compacted)
+    if (journal && (gb->direct.sram_dirty ||
+                    (!journal->pending_compact && (journal->size > 0 || journal->pending))))
+    {
+        journal->compact = true;
+        gb->direct.sram_dirty = true;
+    }
+
+    gb_save_to_disk(gb);
 }
 
 /**
@@ -1267,55 +2019,30 @@ __core_section("fb") void update_fb_dirty_lines(
 
 static void save_check(struct gb_s* gb);
 
-static __section__(".text.tick") void display_fps(void)
+// draws a value in the form "NN.N" at the left edge of the frame, starting at row y0.
+// Returns false if the digits are unchanged since the last call with the same cache.
+static __section__(".text.tick") bool draw_overlay_number(
+    uint8_t* lcd, uint8_t* data, int rowbytes, int height, int y0, int value_x10,
+    uint32_t* last_digits
+)
 {
-    if (!numbers_bmp)
-        return;
-
-    if (++fps_draw_timer % 4 != 0)
-        return;
-
-    float fps;
-    if (CB_App->avg_dt <= 1.0f / 98.5f)
-    {
-        fps = 99.9f;
-    }
-    else
-    {
-        fps = 1.0f / CB_App->avg_dt;
-    }
-
-    // for rounding
-    fps += 0.004f;
-
-    uint8_t* lcd = playdate->graphics->getFrame();
-
-    uint8_t* data;
-    int width, height, rowbytes;
-    playdate->graphics->getBitmapData(numbers_bmp, &width, &height, &rowbytes, NULL, &data);
-
-    if (!data || !lcd)
-        return;
-
     char buff[5];
 
-    int fps_multiplied = (int)(fps * 10.0f);
-
-    if (fps_multiplied > 999)
+    if (value_x10 > 999)
     {
-        fps_multiplied = 999;
+        value_x10 = 999;
     }
 
-    buff[0] = (fps_multiplied / 100) + '0';
-    buff[1] = ((fps_multiplied / 10) % 10) + '0';
+    buff[0] = (value_x10 / 100) + '0';
+    buff[1] = ((value_x10 / 10) % 10) + '0';
     buff[2] = '.';
-    buff[3] = (fps_multiplied % 10) + '0';
+    buff[3] = (value_x10 % 10) + '0';
     buff[4] = '\0';
 
     uint32_t digits4 = *(uint32_t*)&buff[0];
-    if (digits4 == last_fps_digits)
-        return;
-    last_fps_digits = digits4;
+    if (digits4 == *last_digits)
+        return false;
+    *last_digits = digits4;
 
     for (int y = 0; y < height; ++y)
     {
@@ -1346,12 +2073,102 @@ static __section__(".text.tick") void display_fps(void)
 
         for (int i = 0; i < 4; ++i)
         {
-            lcd[y * LCD_ROWSIZE + i] &= (mask >> ((3 - i) * 8));
-            lcd[y * LCD_ROWSIZE + i] |= (out >> ((3 - i) * 8));
+            lcd[(y0 + y) * LCD_ROWSIZE + i] &= (mask >> ((3 - i) * 8));
+            lcd[(y0 + y) * LCD_ROWSIZE + i] |= (out >> ((3 - i) * 8));
         }
     }
 
-    playdate->graphics->markUpdatedRows(0, height - 1);
+    playdate->graphics->markUpdatedRows(y0, y0 + height - 1);
+    return true;
+}
+
+static __section__(".text.tick") void display_fps(CB_GameScene* gameScene)
+{
+    if (!numbers_bmp)
+        return;
+
+    if (++fps_draw_timer % 4 != 0)
+        return;
+
+    float fps;
+    if (CB_App->avg_dt <= 1.0f / 98.5f)
+    {
+        fps = 99.9f;
+    }
+    else
+    {
+        fps = 1.0f / CB_App->avg_dt;
+    }
+
+    // for rounding
+    fps += 0.004f;
+
+    uint8_t* lcd = playdate->graphics->getFrame();
+
+    uint8_t* data;
+    int width, height, rowbytes;
+    playdate->graphics->getBitmapData(numbers_bmp, &width, &height, &rowbytes, NULL, &data);
+
+    if (!data || !lcd)
+        return;
+
+    draw_overlay_number(lcd, data, rowbytes, height, 0, (int)(fps * 10.0f), &last_fps_digits);
+
+    // second row: percentage of frame deadlines missed over the last pacer window
+    if (preferences_display_fps == 3)
+    {
+        int miss_percent_x10 = (int)(CB_App->pacer.miss_rate * 1000.0f + 0.5f);
+        draw_overlay_number(
+            lcd, data, rowbytes, height, height + 1, miss_percent_x10, &last_pacer_digits
+        );
+
+        int row = 2;
+
+        // run-ahead cost per frame, in milliseconds
+        if (preferences_run_ahead && !gameScene->run_ahead_unavailable)
+        {
+            int run_ahead_ms_x10 = (int)(gameScene->run_ahead_cost * 10000.0f + 0.5f);
+            draw_overlay_number(
+                lcd, data, rowbytes, height, row++ * (height + 1), run_ahead_ms_x10,
+                &last_run_ahead_digits
+            );
+        }
+
+        // rewind capture cost per frame in milliseconds, then the history
+        // it fills per second, in KB
+        if (gameScene->rewind)
+        {
+            int capture_ms_x10 = (int)(gameScene->rewind->capture_cost * 10000.0f + 0.5f);
+            int kb_per_second_x10 =
+                (int)(gameScene->rewind->bytes_per_frame * VERTICAL_SYNC * 10.0f / 1024.0f + 0.5f);
+            draw_overlay_number(
+                lcd, data, rowbytes, height, row++ * (height + 1), capture_ms_x10,
+                &last_rewind_cost_digits
+            );
+            draw_overlay_number(
+                lcd, data, rowbytes, height, row++ * (height + 1), kb_per_second_x10,
+                &last_rewind_rate_digits
+            );
+        }
+
+        // audio latency in milliseconds, then the number of audio underruns
+        // and overruns so far
+        if (gameScene->audioEnabled)
+        {
+            struct audio_stats stats;
+            audio_get_stats(&stats);
+
+            int latency_ms_x10 = (int)(stats.latency * 10000.0f / DMG_CLOCK_FREQ + 0.5f);
+            draw_overlay_number(
+                lcd, data, rowbytes, height, row++ * (height + 1), latency_ms_x10,
+                &last_audio_latency_digits
+            );
+            draw_overlay_number(
+                lcd, data, rowbytes, height, row++ * (height + 1),
+                (int)(stats.underruns + stats.overruns) * 10, &last_audio_resync_digits
+            );
+        }
+    }
 }
 
 __section__(".text.tick") __space static void crank_update(CB_GameScene* gameScene, float* progress)
@@ -1423,6 +2240,25 @@ __section__(".text.tick") __space static void crank_update(CB_GameScene* gameSce
         }
     }
 
+    else if (preferences_crank_mode == CRANK_MODE_FAST_FORWARD)
+    {
+        float target = 1.0f + fabsf(CB_App->crankChange) / FAST_FORWARD_DEGREES_PER_STEP;
+        float decayed = gameScene->fast_forward_level * FAST_FORWARD_DECAY;
+        gameScene->fast_forward_level = CB_MIN(FAST_FORWARD_MAX, CB_MAX(target, decayed));
+    }
+
+    else if (preferences_crank_mode == CRANK_MODE_REWIND)
+    {
+        if (CB_App->crankChange <= -REWIND_DEGREES_PER_UPDATE)
+        {
+            gameScene->rewind_hold = REWIND_HOLD_UPDATES;
+        }
+        else if (gameScene->rewind_hold > 0)
+        {
+            gameScene->rewind_hold--;
+        }
+    }
+
     // playdate extension IO registers
     uint16_t crank16 = (angle / 360.0f) * 0x10000;
 
@@ -1452,26 +2288,387 @@ __section__(".text.tick") __space static void crank_update(CB_GameScene* gameSce
     context->gb->direct.crank_docked = 0;
 }
 
-__section__(".text.tick") __space static void CB_GameScene_update(void* object, uint32_t u32enc_dt)
+// sets the A/B/d-pad joypad bits; start and select come from the crank selector.
+__section__(".text.tick") static void apply_joypad_buttons(
+    CB_GameScene* gameScene, struct gb_s* gb, PDButtons buttons
+)
 {
-    // This prevents flicker when transitioning to the Library Scene.
-    if (CB_App->pendingScene)
+    gb->direct.joypad_bits.a = !((buttons & kButtonA) || gameScene->crank_turbo_a_active);
+    gb->direct.joypad_bits.b = !((buttons & kButtonB) || gameScene->crank_turbo_b_active);
+    gb->direct.joypad_bits.left = !(buttons & kButtonLeft);
+    gb->direct.joypad_bits.up = !(buttons & kButtonUp);
+    gb->direct.joypad_bits.right = !(buttons & kButtonRight);
+    gb->direct.joypad_bits.down = !(buttons & kButtonDown);
+}
+
+// Invoked by the core the first time the guest reads P1 in a frame (if
+// late input is enabled), so that the buttons it sees are as fresh as
+// possible rather than sampled before the frame started.
+__section__(".text.tick") static void CB_GameScene_poll_input(struct gb_s* gb)
+{
+    CB_GameSceneContext* context = gb->direct.priv;
+
+    PDButtons buttons;
+    playdate->system->getButtonState(&buttons, NULL, NULL);
+    apply_joypad_buttons(context->scene, gb, buttons & ~CB_App->buttons_suppress);
+
+    // crank register (menu-indexing mode integrates deltas at frame start instead)
+    if (!gb->direct.crank_docked && !gb->direct.ext_crank_menu_indexing)
     {
-        return;
+        float angle = fmaxf(0, fminf(360, playdate->system->getCrankAngle()));
+        gb->direct.crank = (uint16_t)((angle / 360.0f) * 0x10000);
     }
+}
 
-    setCrankSoundsEnabled(
-        !preferences_crank_dock_button && !preferences_crank_undock_button &&
-        preferences_crank_mode != CRANK_MODE_START_SELECT
-    );
+__section__(".text.tick") static void run_frame(struct gb_s* gb)
+{
+#ifdef DTCM_ALLOC
+    DTCM_VERIFY_DEBUG();
+    ITCM_CORE_FN(gb_run_frame)(gb);
+    DTCM_VERIFY_DEBUG();
+#else
+    gb_run_frame(gb);
+#endif
+}
 
-    float dt = UINT32_AS_FLOAT(u32enc_dt);
-    CB_GameScene* gameScene = object;
-    CB_GameSceneContext* context = gameScene->context;
+// allocates the run-ahead snapshot buffer if needed; returns false on failure.
+// (A failure only turns run-ahead off for this session, not in preferences.)
+__section__(".text.tick") static bool run_ahead_prepare(CB_GameScene* gameScene)
+{
+    if (gameScene->run_ahead_snapshot)
+        return true;
+    if (gameScene->run_ahead_unavailable)
+        return false;
 
-    CB_Scene_update(gameScene->scene, dt);
+    gameScene->run_ahead_snapshot = cb_malloc(gb_snapshot_size(gameScene->context->gb));
+    if (!gameScene->run_ahead_snapshot)
+    {
+        playdate->system->logToConsole("Not enough memory for run-ahead.");
+        gameScene->run_ahead_unavailable = true;
+        return false;
+    }
+    gb_snapshot_delta_reset(SNAPSHOT_TRACK_RUN_AHEAD);
+    return true;
+}
 
-    float progress = 0.5f;
+// Snapshots the emulator, runs `count` frames ahead with the current input
+// (showing only the last), then rewinds. Sound is disabled while ahead, so
+// the APU only ever hears the real frames. Only the memory pages written
+// since the last rewind are copied into the snapshot, and back out of it.
+__section__(".text.tick") static void run_ahead_frames(CB_GameScene* gameScene, int count)
+{
+    struct gb_s* gb = gameScene->context->gb;
+    float start = playdate->system->getElapsedTime();
+
+    gb_snapshot_delta_save(gb, SNAPSHOT_TRACK_RUN_AHEAD, gameScene->run_ahead_snapshot, NULL);
+
+    gb->direct.sound = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        gb->direct.frame_skip = i != count - 1;
+        run_frame(gb);
+    }
+
+    gb_snapshot_revert(gb, SNAPSHOT_TRACK_RUN_AHEAD, gameScene->run_ahead_snapshot);
+
+    float cost = playdate->system->getElapsedTime() - start;
+    gameScene->run_ahead_cost =
+        gameScene->run_ahead_cost * FPS_AVG_DECAY + cost * (1 - FPS_AVG_DECAY);
+}
+
+static uint32_t rewind_entry_size(const CB_Rewind* rewind, uint32_t offset)
+{
+    const CB_RewindEntry* entry = (const void*)(rewind->ring + offset);
+    return (sizeof(*entry) + entry->delta_size + entry->keyframe_size + 3) & ~3u;
+}
+
+// forgets the history, starting over from the current state
+__section__(".text.tick") static void rewind_restart(CB_Rewind* rewind, struct gb_s* gb)
+{
+    rewind->head = rewind->tail = rewind->frames = 0;
+    rewind->wrapped = false;
+    rewind->since_keyframe = REWIND_KEYFRAME_INTERVAL;
+    gb_snapshot_delta_reset(SNAPSHOT_TRACK_REWIND);
+    gb_snapshot_delta_save(gb, SNAPSHOT_TRACK_REWIND, rewind->base, NULL);
+}
+
+__section__(".rare") static void rewind_free(CB_GameScene* gameScene)
+{
+    CB_Rewind* rewind = gameScene->rewind;
+    if (!rewind)
+        return;
+
+    cb_free(rewind->ring);
+    cb_free(rewind->base);
+    cb_free(rewind->scratch);
+    cb_free(rewind->lz4_state);
+    cb_free(rewind);
+    gameScene->rewind = NULL;
+}
+
+// allocates the rewind history if needed; returns false on failure.
+// (A failure only turns rewind off for this session, not in preferences.)
+__section__(".text.tick") static bool rewind_prepare(CB_GameScene* gameScene)
+{
+    if (gameScene->rewind)
+        return true;
+    if (gameScene->rewind_unavailable)
+        return false;
+
+    struct gb_s* gb = gameScene->context->gb;
+    CB_Rewind* rewind = cb_calloc(1, sizeof(CB_Rewind));
+    gameScene->rewind = rewind;
+    if (rewind)
+    {
+        rewind->ring = cb_malloc(REWIND_BUDGET);
+        rewind->base = cb_calloc(1, gb_snapshot_size(gb));
+        rewind->scratch = cb_malloc(gb_snapshot_delta_max_size(gb));
+        rewind->lz4_state = cb_malloc(LZ4_sizeofState());
+    }
+
+    if (!rewind || !rewind->ring || !rewind->base || !rewind->scratch || !rewind->lz4_state)
+    {
+        playdate->system->logToConsole("Not enough memory for rewind.");
+        rewind_free(gameScene);
+        gameScene->rewind_unavailable = true;
+        return false;
+    }
+
+    rewind_restart(rewind, gb);
+    return true;
+}
+
+// drops the oldest entry
+__section__(".text.tick") static void rewind_evict(CB_Rewind* rewind)
+{
+    rewind->tail += rewind_entry_size(rewind, rewind->tail);
+    rewind->frames--;
+    if (rewind->wrapped && rewind->tail == rewind->end)
+    {
+        rewind->tail = 0;
+        rewind->wrapped = false;
+    }
+}
+
+// finds room for an entry of up to `size` bytes after the newest, evicting
+// the oldest entries as needed; returns its offset.
+__section__(".text.tick") static uint32_t rewind_reserve(CB_Rewind* rewind, uint32_t size)
+{
+    for (;;)
+    {
+        if (rewind->frames == 0)
+        {
+            rewind->head = rewind->tail = 0;
+            rewind->wrapped = false;
+            return 0;
+        }
+
+        if (!rewind->wrapped)
+        {
+            if (rewind->head + size <= REWIND_BUDGET)
+                return rewind->head;
+
+            rewind->end = rewind->head;
+            rewind->head = 0;
+            rewind->wrapped = true;
+        }
+        else if (rewind->head + size <= rewind->tail)
+        {
+            return rewind->head;
+        }
+        else
+        {
+            rewind_evict(rewind);
+        }
+    }
+}
+
+// drops the newest entry
+__section__(".text.tick") static void rewind_pop(CB_Rewind* rewind)
+{
+    const uint32_t offset = rewind->newest;
+    rewind->newest = ((const CB_RewindEntry*)(rewind->ring + offset))->prev;
+
+    if (--rewind->frames == 0)
+    {
+        rewind->head = rewind->tail = 0;
+        rewind->wrapped = false;
+    }
+    else if (rewind->wrapped && offset == 0)
+    {
+        rewind->head = rewind->end;
+        rewind->wrapped = false;
+    }
+    else
+    {
+        rewind->head = offset;
+    }
+}
+
+// adds the frame just run to the rewind history
+__section__(".text.tick") static void rewind_capture(CB_GameScene* gameScene)
+{
+    CB_Rewind* rewind = gameScene->rewind;
+    struct gb_s* gb = gameScene->context->gb;
+    float start = playdate->system->getElapsedTime();
+
+    const int delta_size =
+        gb_snapshot_delta_save_xor(gb, SNAPSHOT_TRACK_REWIND, rewind->base, rewind->scratch);
+    const int delta_bound = LZ4_compressBound(delta_size);
+
+    // the base now holds the complete state, which is what a keyframe is
+    const bool keyframe = rewind->since_keyframe + 1 >= REWIND_KEYFRAME_INTERVAL;
+    const int base_size = gb_snapshot_size(gb);
+    const int keyframe_bound = keyframe ? LZ4_compressBound(base_size) : 0;
+
+    // A frame that can't be stored is skipped: the base steps back to the
+    // newest entry's state, so that the next frame's delta spans both.
+    const uint32_t reserve = sizeof(CB_RewindEntry) + delta_bound + keyframe_bound;
+    if (reserve > REWIND_BUDGET)
+    {
+        playdate->system->logToConsole("Rewind: frame too large (%u bytes); skipped.", reserve);
+        gb_snapshot_delta_discard(gb, SNAPSHOT_TRACK_REWIND, rewind->base, rewind->scratch);
+        return;
+    }
+
+    const uint32_t offset = rewind_reserve(rewind, reserve);
+    CB_RewindEntry* entry = (void*)(rewind->ring + offset);
+    char* data = (char*)(entry + 1);
+
+    entry->prev = rewind->newest;
+    entry->delta_size = LZ4_compress_fast_extState(
+        rewind->lz4_state, (const char*)rewind->scratch, data, delta_size, delta_bound, 1
+    );
+    if (entry->delta_size == 0)
+    {
+        playdate->system->logToConsole("Rewind: couldn't compress frame; skipped.");
+        gb_snapshot_delta_discard(gb, SNAPSHOT_TRACK_REWIND, rewind->base, rewind->scratch);
+        return;
+    }
+
+    // (without its keyframe, the entry is still usable; the next frame tries again)
+    entry->keyframe_size = 0;
+    rewind->since_keyframe++;
+    if (keyframe)
+    {
+        entry->keyframe_size = LZ4_compress_fast_extState(
+            rewind->lz4_state, (const char*)rewind->base, data + entry->delta_size, base_size,
+            keyframe_bound, 1
+        );
+        if (entry->keyframe_size > 0)
+        {
+            rewind->since_keyframe = 0;
+        }
+    }
+
+    const uint32_t size = rewind_entry_size(rewind, offset);
+    rewind->newest = offset;
+    rewind->head = offset + size;
+    rewind->frames++;
+
+    float cost = playdate->system->getElapsedTime() - start;
+    rewind->capture_cost = rewind->capture_cost * FPS_AVG_DECAY + cost * (1 - FPS_AVG_DECAY);
+    rewind->bytes_per_frame =
+        rewind->bytes_per_frame * FPS_AVG_DECAY + size * (1 - FPS_AVG_DECAY);
+}
+
+// Steps the emulator (and the base) back one frame through the rewind
+// history; returns false if there is none left.
+__section__(".text.tick") static bool rewind_step(CB_GameScene* gameScene)
+{
+    CB_Rewind* rewind = gameScene->rewind;
+    struct gb_s* gb = gameScene->context->gb;
+
+    if (rewind->frames == 0)
+        return false;
+
+    const CB_RewindEntry* entry = (const void*)(rewind->ring + rewind->newest);
+    int size = LZ4_decompress_safe(
+        (const char*)(entry + 1), (char*)rewind->scratch, entry->delta_size,
+        gb_snapshot_delta_max_size(gb)
+    );
+    if (size <= 0)
+    {
+        rewind_restart(rewind, gb);
+        return false;
+    }
+
+    gb_snapshot_delta_unxor(gb, SNAPSHOT_TRACK_REWIND, rewind->base, rewind->scratch);
+    rewind_pop(rewind);
+
+    // keyframe of the state we've arrived at, if it has one
+    if (rewind->frames > 0)
+    {
+        entry = (const void*)(rewind->ring + rewind->newest);
+        if (entry->keyframe_size > 0)
+        {
+            const int base_size = gb_snapshot_size(gb);
+            size = LZ4_decompress_safe(
+                (const char*)(entry + 1) + entry->delta_size, (char*)rewind->base,
+                entry->keyframe_size, base_size
+            );
+            if (size != base_size)
+            {
+                rewind_restart(rewind, gb);
+                return false;
+            }
+            gb_snapshot_restore(gb, rewind->base, false);
+            gb_snapshot_delta_save(gb, SNAPSHOT_TRACK_REWIND, NULL, NULL);
+        }
+    }
+
+    return true;
+}
+
+// Steps back `count` frames through the rewind history, then shows the
+// frame which followed (by running it with sound off, then reverting). The
+// APU isn't part of the history, so its clock just keeps running.
+__section__(".text.tick") static void rewind_frames(CB_GameScene* gameScene, int count)
+{
+    struct gb_s* gb = gameScene->context->gb;
+    const uint32_t audio_cycles = gb->audio_cycles;
+    int steps = 0;
+
+    while (steps < count && rewind_step(gameScene))
+    {
+        steps++;
+    }
+
+    gb->direct.sound = 0;
+    gb->direct.frame_skip = 0;
+    run_frame(gb);
+    gb_snapshot_revert(gb, SNAPSHOT_TRACK_REWIND, gameScene->rewind->base);
+
+    gb->audio_cycles = audio_cycles + steps * LCD_FRAME_CYCLES;
+    if (gb->direct.sound)
+    {
+        audio_sync(gb->audio_cycles);
+    }
+}
+
+__section__(".text.tick") __space static void CB_GameScene_update(void* object, uint32_t u32enc_dt)
+{
+    // This prevents flicker when transitioning to the Library Scene.
+    if (CB_App->pendingScene)
+    {
+        return;
+    }
+
+    setCrankSoundsEnabled(
+        !preferences_crank_dock_button && !preferences_crank_undock_button &&
+        preferences_crank_mode != CRANK_MODE_START_SELECT
+    );
+
+    float dt = UINT32_AS_FLOAT(u32enc_dt);
+    CB_GameScene* gameScene = object;
+    CB_GameSceneContext* context = gameScene->context;
+
+    uint32_t frame_start_ms =
+        gameScene->state_load_ms ? playdate->system->getCurrentTimeMilliseconds() : 0;
+
+    CB_Scene_update(gameScene->scene, dt);
+
+    float progress = 0.5f;
 
     // Check whether drawing transparent pixels is enabled.
     context->gb->direct.transparency_enabled = preferences_transparency;
@@ -1613,6 +2810,8 @@ __section__(".text.tick") __space static void CB_GameScene_update(void* object,
         {
             gameScene->crank_turbo_accumulator = 0.0f;
         }
+        gameScene->fast_forward_level = 1.0f;
+        gameScene->rewind_hold = 0;
         context->gb->direct.crank_menu_delta = 0;
         context->gb->direct.crank_menu_accumulation = 0x8000;
     }
@@ -1737,14 +2936,11 @@ __section__(".text.tick") __space static void CB_GameScene_update(void* object,
         context->gb->direct.joypad_bits.start = gb_joypad_start_is_active_low;
         context->gb->direct.joypad_bits.select = gb_joypad_select_is_active_low;
 
-        context->gb->direct.joypad_bits.a =
-            !((current_pd_buttons & kButtonA) || gameScene->crank_turbo_a_active);
-        context->gb->direct.joypad_bits.b =
-            !((current_pd_buttons & kButtonB) || gameScene->crank_turbo_b_active);
-        context->gb->direct.joypad_bits.left = !(current_pd_buttons & kButtonLeft);
-        context->gb->direct.joypad_bits.up = !(current_pd_buttons & kButtonUp);
-        context->gb->direct.joypad_bits.right = !(current_pd_buttons & kButtonRight);
-        context->gb->direct.joypad_bits.down = !(current_pd_buttons & kButtonDown);
+        apply_joypad_buttons(gameScene, context->gb, current_pd_buttons);
+
+        context->gb->direct.late_input = preferences_late_input;
+        gameScene->late_input_polls += context->gb->direct.input_polls;
+        context->gb->direct.input_polls = 0;
 
         if (context->gb->direct.joypad_interrupts)
         {
@@ -1775,9 +2971,22 @@ __section__(".text.tick") __space static void CB_GameScene_update(void* object,
             gameScene->previous_joypad_state = new_joypad_state;
         }
 
-        context->gb->overclock = (unsigned)(preferences_overclock);
+        if (preferences_overclock >= OVERCLOCK_AUTO)
+        {
+            // the core raises/lowers overclock per frame while the game lags
+            context->gb->overclock_auto = 1;
+            context->gb->overclock_max = preferences_overclock - OVERCLOCK_AUTO + 1;
+        }
+        else
+        {
+            context->gb->overclock_auto = 0;
+            context->gb->overclock = (unsigned)(preferences_overclock);
+        }
         if (context->gb->gb_bios_enable)
+        {
+            context->gb->overclock_auto = 0;
             context->gb->overclock = 0;  // overclocked boot ROM is glitchy
+        }
 
         if (gbScreenRequiresFullRefresh)
         {
@@ -1799,11 +3008,9 @@ __section__(".text.tick") __space static void CB_GameScene_update(void* object,
 
         struct gb_s* tmp_gb = context->gb;
 
-#ifdef TARGET_SIMULATOR
-        pthread_mutex_lock(&audio_mutex);
-#endif
-
-        // copy gb to stack (DTCM) temporarily only if dtcm not enabled
+        // copy gb to stack (DTCM) temporarily only if dtcm not enabled.
+        // The audio state is owned by the audio callback and stays put;
+        // register writes reach it through the (lock-free) audio queue.
         int stack_gb_size = 1;
         if (!dtcm_enabled())
         {
@@ -1812,42 +3019,116 @@ __section__(".text.tick") __space static void CB_GameScene_update(void* object,
         char stack_gb_data[stack_gb_size];
         if (!dtcm_enabled())
         {
-            gameScene->audioLocked = 1;
-            memcpy(stack_gb_data, tmp_gb, sizeof(struct gb_s));
+            memcpy(stack_gb_data, tmp_gb, offsetof(struct gb_s, audio));
             context->gb = (void*)stack_gb_data;
-            gameScene->audioLocked = 0;
         }
 
-        gameScene->playtime += 1 + preferences_frame_skip;
-        CB_App->avg_dt_mult =
-            (preferences_frame_skip && preferences_display_fps == 1) ? 0.5f : 1.0f;
-        for (int frame = 0; frame <= preferences_frame_skip; ++frame)
+        // while fast-forwarding, only the last frame of the batch is rendered.
+        // The audio callback can't keep up with the burst of register writes,
+        // so it skips forward and sound from the skipped frames is dropped.
+        int fast_forward = 1;
+        if (preferences_crank_mode == CRANK_MODE_FAST_FORWARD)
         {
-            context->gb->direct.frame_skip = preferences_frame_skip != frame;
-#ifdef DTCM_ALLOC
-            DTCM_VERIFY_DEBUG();
-            ITCM_CORE_FN(gb_run_frame)(context->gb);
-            DTCM_VERIFY_DEBUG();
-#else
-            gb_run_frame(context->gb);
-#endif
+            fast_forward = CB_MAX(1, (int)(gameScene->fast_forward_level + 0.5f));
+        }
+
+        int frame_count = (1 + preferences_frame_skip) * fast_forward;
+        gameScene->playtime += frame_count;
+        CB_App->avg_dt_mult = (preferences_display_fps == 1) ? 1.0f / frame_count : 1.0f;
+
+        // follow the audio clock if it has drifted too far from the display's
+        if (gameScene->audioEnabled && fast_forward == 1)
+        {
+            frame_count += audio_frame_correction();
+        }
+
+        // run-ahead and rewind can't be used while a script is active (as
+        // breakpoints have side effects) or while the boot rom is mapped.
+        bool scriptable = !context->scene->script && !context->gb->gb_bios_enable;
+        bool run_ahead = preferences_run_ahead > 0 && scriptable && run_ahead_prepare(gameScene);
+
+        if (preferences_crank_mode != CRANK_MODE_REWIND)
+        {
+            rewind_free(gameScene);
+        }
+        bool rewind = preferences_crank_mode == CRANK_MODE_REWIND && scriptable &&
+                      rewind_prepare(gameScene);
+
+        if (rewind && gameScene->rewind_hold > 0)
+        {
+            rewind_frames(gameScene, frame_count);
+            run_ahead = false;
+        }
+        else
+        {
+            for (int frame = 0; frame < frame_count; ++frame)
+            {
+                // with run-ahead, the real frames are never shown
+                context->gb->direct.frame_skip = run_ahead || frame != frame_count - 1;
+                run_frame(context->gb);
+
+                if (rewind)
+                {
+                    rewind_capture(gameScene);
+                }
+            }
+        }
+
+        if (run_ahead)
+        {
+            run_ahead_frames(gameScene, preferences_run_ahead);
+        }
+        else
+        {
+            gameScene->run_ahead_cost = 0;
         }
 
         if (!dtcm_enabled())
         {
-            gameScene->audioLocked = 1;
-            memcpy(tmp_gb, context->gb, sizeof(struct gb_s));
+            memcpy(tmp_gb, context->gb, offsetof(struct gb_s, audio));
             context->gb = tmp_gb;
-            gameScene->audioLocked = 0;
         }
 
-#ifdef TARGET_SIMULATOR
-        pthread_mutex_unlock(&audio_mutex);
-#endif
+        if (dt > 0)
+        {
+            float achieved = frame_count / (dt * VERTICAL_SYNC);
+            gameScene->fast_forward_achieved = gameScene->fast_forward_achieved * FPS_AVG_DECAY +
+                                               achieved * (1 - FPS_AVG_DECAY);
+        }
+
+        if (preferences_crank_mode == CRANK_MODE_FAST_FORWARD)
+        {
+            uint8_t label = (uint8_t)CB_MIN(
+                2 * FAST_FORWARD_MAX, (int)(gameScene->fast_forward_achieved * 2.0f + 0.5f)
+            );
+            if (label != gameScene->fast_forward_label)
+            {
+                gameScene->fast_forward_label = label;
+                gameScene->staticSelectorUIDrawn = false;
+            }
+        }
+
+        if (gameScene->rewind)
+        {
+            uint8_t label = (uint8_t)CB_MIN(99, gameScene->rewind->frames / 60);
+            if (label != gameScene->rewind_label)
+            {
+                gameScene->rewind_label = label;
+                gameScene->staticSelectorUIDrawn = false;
+            }
+        }
 
         if (gameScene->cartridge_has_battery)
         {
             save_check(context->gb);
+            sram_save_step(gameScene);
+        }
+
+        if (gameScene->save_job)
+        {
+            gameScene->save_job->frames++;
+            gameScene->save_job->worst_dt = CB_MAX(gameScene->save_job->worst_dt, dt);
+            save_job_advance(gameScene);
         }
 
         // --- Conditional Screen Update (Drawing) Logic ---
@@ -2035,6 +3316,16 @@ __section__(".text.tick") __space static void CB_GameScene_update(void* object,
             );
         }
 
+        if unlikely (gameScene->state_load_ms)
+        {
+            uint32_t frame_ms = playdate->system->getCurrentTimeMilliseconds() - frame_start_ms;
+            playdate->system->logToConsole(
+                "State load: %u ms, then %u ms to the first frame", gameScene->state_load_ms,
+                frame_ms
+            );
+            gameScene->state_load_ms = 0;
+        }
+
         // Always request the update loop to run at 30 FPS.
         // (60 game boy frames per second.)
         // This ensures gb_run_frame() is called at a consistent rate.
@@ -2098,9 +3389,11 @@ __section__(".text.tick") __space static void CB_GameScene_update(void* object,
                 );
             }
 
-            // Draw the "Turbo" indicator if needed.
+            // Draw the "Turbo" or fast-forward indicator if needed.
             if (preferences_crank_mode == CRANK_MODE_TURBO_CW ||
-                preferences_crank_mode == CRANK_MODE_TURBO_CCW)
+                preferences_crank_mode == CRANK_MODE_TURBO_CCW ||
+                preferences_crank_mode == CRANK_MODE_FAST_FORWARD ||
+                preferences_crank_mode == CRANK_MODE_REWIND)
             {
                 playdate->graphics->setFont(CB_App->labelFont);
                 playdate->graphics->setDrawMode(kDrawModeFillWhite);
@@ -2108,6 +3401,23 @@ __section__(".text.tick") __space static void CB_GameScene_update(void* object,
                 const char* line1 = "Turbo";
                 const char* line2 = (preferences_crank_mode == CRANK_MODE_TURBO_CW) ? "A/B" : "B/A";
 
+                // achieved speed, relative to real time
+                char ff_buff[8];
+                if (preferences_crank_mode == CRANK_MODE_FAST_FORWARD)
+                {
+                    unsigned label = gameScene->fast_forward_label;
+                    line1 = "Speed";
+                    snprintf(ff_buff, sizeof(ff_buff), "x%u.%u", label / 2, (label % 2) * 5);
+                    line2 = ff_buff;
+                }
+                else if (preferences_crank_mode == CRANK_MODE_REWIND)
+                {
+                    // seconds of history held
+                    line1 = "Rewind";
+                    snprintf(ff_buff, sizeof(ff_buff), "%us", gameScene->rewind_label);
+                    line2 = ff_buff;
+                }
+
                 int fontHeight = playdate->graphics->getFontHeight(CB_App->labelFont);
                 int lineSpacing = 2;
                 int paddingBottom = 6;
@@ -2210,7 +3520,7 @@ __section__(".text.tick") __space static void CB_GameScene_update(void* object,
 
         if (preferences_display_fps)
         {
-            display_fps();
+            display_fps(gameScene);
         }
     }
     else if (gameScene->state == CB_GameSceneStateError)
@@ -2328,14 +3638,74 @@ __section__(".text.tick") __space static void save_check(struct gb_s* gb)
         frames_since_sram_update++;
     }
 
+    sram_flush_pending = false;
     if (gb->cart_battery && gb->direct.sram_dirty && !gb->direct.sram_updated)
     {
-        if (frames_since_sram_update >= CB_IDLE_FRAMES_BEFORE_SAVE)
+        if (frames_since_sram_update >= CB_IDLE_FRAMES_BEFORE_SAVE + SRAM_FLUSH_SLACK_GRACE)
         {
+            // the frame pacer never had time to spare; save anyway.
             playdate->system->logToConsole("Saving (idle detected)");
-            gb_save_to_disk(gb);
+            gb_save_to_disk_async(gb);
+        }
+        else if (frames_since_sram_update >= CB_IDLE_FRAMES_BEFORE_SAVE)
+        {
+            // prefer to save in the pacer's slack time (see CB_GameScene_slack)
+            sram_flush_pending = true;
+        }
+    }
+}
+
+// Invoked by the frame pacer with time to spare before the next frame.
+__section__(".text.tick") static bool CB_GameScene_slack(void* object, float remaining)
+{
+    CB_GameScene* gameScene = object;
+
+    if (gameScene->state != CB_GameSceneStateLoaded)
+        return false;
+
+    // (SRAM work only if the slowest of its kind so far would still fit;
+    // save_check saves anyway if no slack shows up for long enough)
+    CB_SramJournal* journal = gameScene->sram_journal;
+
+    if (sram_flush_pending && (!journal || slack_fits(&journal->worst_begin, remaining)))
+    {
+        sram_flush_pending = false;
+        playdate->system->logToConsole("Saving (idle detected)");
+
+        float start = playdate->system->getElapsedTime();
+        gb_save_to_disk_async(gameScene->context->gb);
+        if (journal)
+        {
+            slack_worst_update(&journal->worst_begin, start);
         }
+        return true;
+    }
+
+    if (journal && journal->pending && slack_fits(&journal->worst_step, remaining))
+    {
+        sram_save_step(gameScene);
+        return true;
+    }
+
+    // (only if the slowest recent step would still fit)
+    if (gameScene->save_job && slack_fits(&gameScene->save_job->slack_step, remaining))
+    {
+        save_job_advance(gameScene);
+        return true;
     }
+
+    // (likewise re-deriving a missing slot index from the files, one slot at a time)
+    CB_StateIndex* index = gameScene->state_index;
+    if (index && index->unchecked && !gameScene->save_job &&
+        slack_fits(&index->worst_check, remaining))
+    {
+        float start = playdate->system->getElapsedTime();
+        state_index_check_next(gameScene);
+        slack_worst_update(&index->worst_check, start);
+        return true;
+    }
+
+    return false;
 }
 
 void CB_LibraryConfirmModal(void* userdata, int option)
@@ -2743,214 +4113,849 @@ static void CB_GameScene_generateBitmask(void)
     }
 }
 
-__section__(".rare") static unsigned get_save_state_timestamp_(
-    CB_GameScene* gameScene, unsigned slot
-)
+static char* save_state_path(CB_GameScene* gameScene, unsigned slot, const char* extension)
 {
     char* path;
     playdate->system->formatString(
-        &path, "%s/%s.%u.state", CB_statesPath, gameScene->base_filename, slot
+        &path, "%s/%s.%u.%s", CB_statesPath, gameScene->base_filename, slot, extension
     );
+    return path;
+}
 
-    SDFile* file = playdate->file->open(path, kFileReadData);
-
-    cb_free(path);
-
-    if (!file)
+// the newest save job for the slot which isn't yet on disk, if any
+static CB_SaveJob* save_job_for_slot(CB_GameScene* gameScene, unsigned slot)
+{
+    CB_SaveJob* found = NULL;
+    for (CB_SaveJob* job = gameScene->save_job; job; job = job->next)
     {
-        return 0;
+        if (job->slot == slot)
+            found = job;
     }
+    return found;
+}
 
-    struct StateHeader header;
-    int read = playdate->file->read(file, &header, sizeof(header));
-    playdate->file->close(file);
-    if (read < sizeof(header))
-    {
-        return 0;
-    }
-    else
+__section__(".rare") static void save_job_free(CB_SaveJob* job)
+{
+    if (job->file)
     {
-        return header.timestamp;
+        playdate->file->close(job->file);
     }
+    cb_free(job->buff);
+    cb_free(job->lcd);
+    cb_free(job);
 }
 
-__section__(".rare") unsigned get_save_state_timestamp(CB_GameScene* gameScene, unsigned slot)
-{
-    return (unsigned)call_with_main_stack_2(get_save_state_timestamp_, gameScene, slot);
-}
+// 1-bit thumbnail bits for each packed LCD byte (4 pixels), by row parity.
+// The high nibble is the output for an even byte of the row, and the low
+// nibble for an odd one, since the dither pattern repeats every 8 pixels.
+static uint8_t thumbnail_lut[2][256];
+static bool thumbnail_lut_ready;
 
-// returns true if successful
-__section__(".rare") static bool save_state_(CB_GameScene* gameScene, unsigned slot)
+__section__(".rare") static void save_state_thumbnail_init(void)
 {
-    playdate->system->logToConsole("save state %p", __builtin_frame_address(0));
+    static const uint8_t dither_pattern[5] = {
+        0b00000000 ^ 0xFF, 0b01000100 ^ 0xFF, 0b10101010 ^ 0xFF,
+        0b11011101 ^ 0xFF, 0b11111111 ^ 0xFF,
+    };
 
-    if (gameScene->isCurrentlySaving)
+    for (unsigned parity = 0; parity < 2; ++parity)
     {
-        playdate->system->logToConsole("Save state failed: another save is in progress.");
-        return false;
+        for (unsigned packed = 0; packed < 256; ++packed)
+        {
+            uint8_t bits = 0;
+            for (unsigned x = 0; x < 8; ++x)
+            {
+                // very bespoke dithering algorithm lol
+                // (each pixel is shaded by its pair's neighbour)
+                u8 p0 = (packed >> ((x % LCD_PACKING) * LCD_BITS_PER_PIXEL)) & 3;
+                u8 p1 = (packed >> (((x ^ 1) % LCD_PACKING) * LCD_BITS_PER_PIXEL)) & 3;
+
+                u8 val = p0;
+                if (val >= 2)
+                    val++;
+                if (val == 1 && p1 >= 2)
+                    ++val;
+                if (val == 3 && p1 < 2)
+                    --val;
+
+                u8 pattern = dither_pattern[val];
+                if (parity == 1)
+                {
+                    if (val == 2)
+                        pattern = (pattern >> 1) | (pattern << 7);
+                    else
+                        pattern = (pattern >> 2) | (pattern << 6);
+                }
+
+                bits |= ((pattern >> x) & 1) << (7 - x);
+            }
+            thumbnail_lut[parity][packed] = bits;
+        }
     }
 
-    gameScene->isCurrentlySaving = true;
+    thumbnail_lut_ready = true;
+}
 
-    CB_GameSceneContext* context = gameScene->context;
+__section__(".rare") void save_state_thumbnail(const uint8_t* lcd, uint8_t* out)
+{
+    if (!thumbnail_lut_ready)
+    {
+        save_state_thumbnail_init();
+    }
+
+    // two packed bytes per output byte (SAVE_STATE_THUMBNAIL_W is a multiple of 8)
+    for (unsigned y = 0; y < SAVE_STATE_THUMBNAIL_H; ++y)
+    {
+        const uint8_t* line = lcd + y * LCD_WIDTH_PACKED;
+        const uint8_t* lut = thumbnail_lut[y % 2];
+        uint8_t* thumbline = out + y * (SAVE_STATE_THUMBNAIL_W / 8);
+
+        for (unsigned x = 0; x < SAVE_STATE_THUMBNAIL_W / 8; ++x)
+        {
+            thumbline[x] = (lut[line[2 * x]] & 0xF0) | (lut[line[2 * x + 1]] & 0x0F);
+        }
+    }
+}
+
+static char* state_index_path(CB_GameScene* gameScene, const char* extension)
+{
+    char* path;
+    playdate->system->formatString(
+        &path, "%s/%s.%s", CB_statesPath, gameScene->base_filename, extension
+    );
+    return path;
+}
+
+// the file's modification time as an epoch, or 0 if it doesn't exist
+static uint32_t state_file_mtime(const char* path, uint32_t* size)
+{
+    FileStat stat;
+    if (playdate->file->stat(path, &stat) != 0)
+    {
+        *size = 0;
+        return 0;
+    }
+
+    struct PDDateTime dt = {
+        .year = stat.m_year,
+        .month = stat.m_month,
+        .day = stat.m_day,
+        .hour = stat.m_hour,
+        .minute = stat.m_minute,
+        .second = stat.m_second
+    };
+    *size = stat.size;
+    return playdate->system->convertDateTimeToEpoch(&dt);
+}
+
+// sets the slot's thumbnail, or clears it if thumbnail is NULL
+__section__(".rare") static void state_index_set_thumbnail(
+    CB_StateIndex* index, unsigned slot, const uint8_t* thumbnail
+)
+{
+    cb_free(index->thumbnails[slot]);
+    index->thumbnails[slot] = NULL;
+    index->entries[slot].thumbnail_size = 0;
+
+    if (!thumbnail)
+        return;
+
+    uint8_t* packed = cb_malloc(STATE_THUMBNAIL_SIZE);
+    void* lz4_state = cb_malloc(LZ4_sizeofState());
+    if (!packed || !lz4_state)
+    {
+        cb_free(packed);
+        cb_free(lz4_state);
+        return;
+    }
+
+    int size = LZ4_compress_fast_extState(
+        lz4_state, (const char*)thumbnail, (char*)packed, STATE_THUMBNAIL_SIZE,
+        STATE_THUMBNAIL_SIZE - 1, 1
+    );
+    cb_free(lz4_state);
+
+    if (size <= 0)
+    {
+        // stored as-is
+        memcpy(packed, thumbnail, STATE_THUMBNAIL_SIZE);
+        size = STATE_THUMBNAIL_SIZE;
+    }
+    else
+    {
+        uint8_t* shrunk = cb_realloc(packed, size);
+        if (shrunk)
+            packed = shrunk;
+    }
+
+    index->thumbnails[slot] = packed;
+    index->entries[slot].thumbnail_size = size;
+}
+
+__section__(".rare") static bool state_index_get_thumbnail(
+    const CB_StateIndex* index, unsigned slot, uint8_t* out
+)
+{
+    int size = index->entries[slot].thumbnail_size;
+    if (size == 0 || !index->thumbnails[slot])
+        return false;
+
+    if (size == STATE_THUMBNAIL_SIZE)
+    {
+        memcpy(out, index->thumbnails[slot], STATE_THUMBNAIL_SIZE);
+        return true;
+    }
+
+    return LZ4_decompress_safe(
+               (const char*)index->thumbnails[slot], (char*)out, size, STATE_THUMBNAIL_SIZE
+           ) == STATE_THUMBNAIL_SIZE;
+}
+
+__section__(".rare") static void state_index_clear(CB_StateIndex* index)
+{
+    for (unsigned slot = 0; slot < SAVE_STATE_SLOT_COUNT; ++slot)
+    {
+        cb_free(index->thumbnails[slot]);
+    }
+    memset(index, 0, sizeof(*index));
+}
+
+// reads as much as possible of the file into out; returns the bytes read
+__section__(".rare") static int read_fully(SDFile* file, void* out, int size)
+{
+    int total = 0;
+    while (total < size)
+    {
+        int read = playdate->file->read(file, (uint8_t*)out + total, size - total);
+        if (read <= 0)
+            break;
+        total += read;
+    }
+    return total;
+}
+
+// Re-derives the slot's entry from its .state and .thumb files.
+__section__(".rare") static void state_index_heal(
+    CB_GameScene* gameScene, CB_StateIndex* index, unsigned slot
+)
+{
+    CB_StateIndexEntry* entry = &index->entries[slot];
+    state_index_set_thumbnail(index, slot, NULL);
+    memset(entry, 0, sizeof(*entry));
+
+    char* path = save_state_path(gameScene, slot, "state");
+    uint32_t size;
+    uint32_t mtime = state_file_mtime(path, &size);
+
+    uint8_t* buff = (size >= sizeof(struct StateHeader)) ? cb_malloc(size) : NULL;
+    SDFile* file = buff ? playdate->file->open(path, kFileReadData) : NULL;
+    cb_free(path);
+
+    if (file)
+    {
+        if (read_fully(file, buff, size) == size)
+        {
+            const struct StateHeader* header = (const struct StateHeader*)buff;
+            entry->size = size;
+            entry->crc = crc32_for_buffer(buff, size);
+            entry->mtime = mtime;
+            entry->timestamp = header->timestamp;
+            entry->script = header->script;
+        }
+        playdate->file->close(file);
+    }
+    cb_free(buff);
+
+    if (entry->size == 0)
+        return;
+
+    path = save_state_path(gameScene, slot, "thumb");
+    file = playdate->file->open(path, kFileReadData);
+    cb_free(path);
+
+    if (file)
+    {
+        uint8_t thumbnail[STATE_THUMBNAIL_SIZE];
+        if (read_fully(file, thumbnail, sizeof(thumbnail)) == sizeof(thumbnail))
+        {
+            state_index_set_thumbnail(index, slot, thumbnail);
+        }
+        playdate->file->close(file);
+    }
+}
+
+// Returns false if the index file is missing or damaged.
+__section__(".rare") static bool state_index_read(CB_GameScene* gameScene, CB_StateIndex* index)
+{
+    char* path = state_index_path(gameScene, "index");
+    SDFile* file = playdate->file->open(path, kFileReadData);
+    cb_free(path);
+
+    if (!file)
+        return false;
+
+    playdate->file->seek(file, 0, SEEK_END);
+    int size = playdate->file->tell(file);
+    playdate->file->seek(file, 0, SEEK_SET);
+
+    const int entries_end = sizeof(CB_StateIndexHeader) + sizeof(index->entries);
+    uint8_t* buff = (size >= entries_end) ? cb_malloc(size) : NULL;
+    bool valid = buff && read_fully(file, buff, size) == size;
+    playdate->file->close(file);
+
+    if (valid)
+    {
+        CB_StateIndexHeader header;
+        memcpy(&header, buff, sizeof(header));
+        valid = header.magic == STATE_INDEX_MAGIC && header.version == STATE_INDEX_VERSION &&
+                header.slots == SAVE_STATE_SLOT_COUNT &&
+                header.crc == crc32_for_buffer(buff + sizeof(header), size - sizeof(header));
+    }
+
+    if (valid)
+    {
+        memcpy(index->entries, buff + sizeof(CB_StateIndexHeader), sizeof(index->entries));
+
+        int offset = entries_end;
+        for (unsigned slot = 0; valid && slot < SAVE_STATE_SLOT_COUNT; ++slot)
+        {
+            int thumbnail_size = index->entries[slot].thumbnail_size;
+            if (thumbnail_size > STATE_THUMBNAIL_SIZE || offset + thumbnail_size > size)
+            {
+                valid = false;
+            }
+            else if (thumbnail_size > 0)
+            {
+                index->thumbnails[slot] = cb_malloc(thumbnail_size);
+                if (index->thumbnails[slot])
+                    memcpy(index->thumbnails[slot], buff + offset, thumbnail_size);
+                else
+                    index->entries[slot].thumbnail_size = 0;
+            }
+            offset += thumbnail_size;
+        }
+    }
+
+    cb_free(buff);
+
+    if (!valid)
+    {
+        state_index_clear(index);
+    }
+    return valid;
+}
+
+// Rewrites the index file by way of a temporary one, keeping the previous
+// index until the new one is in place.
+__section__(".rare") static bool state_index_write(
+    CB_GameScene* gameScene, const CB_StateIndex* index
+)
+{
+    uint32_t size = sizeof(CB_StateIndexHeader) + sizeof(index->entries);
+    for (unsigned slot = 0; slot < SAVE_STATE_SLOT_COUNT; ++slot)
+    {
+        size += index->entries[slot].thumbnail_size;
+    }
+
+    uint8_t* buff = cb_malloc(size);
+    if (!buff)
+    {
+        playdate->system->logToConsole("Failed to allocate save state index");
+        return false;
+    }
+
+    uint32_t offset = sizeof(CB_StateIndexHeader);
+    memcpy(buff + offset, index->entries, sizeof(index->entries));
+    offset += sizeof(index->entries);
+    for (unsigned slot = 0; slot < SAVE_STATE_SLOT_COUNT; ++slot)
+    {
+        memcpy(buff + offset, index->thumbnails[slot], index->entries[slot].thumbnail_size);
+        offset += index->entries[slot].thumbnail_size;
+    }
+
+    CB_StateIndexHeader header = {
+        STATE_INDEX_MAGIC, STATE_INDEX_VERSION, SAVE_STATE_SLOT_COUNT,
+        crc32_for_buffer(buff + sizeof(header), size - sizeof(header))
+    };
+    memcpy(buff, &header, sizeof(header));
+
+    char* index_name = state_index_path(gameScene, "index");
+    char* tmp_name = state_index_path(gameScene, "index.tmp");
+    char* bak_name = state_index_path(gameScene, "index.bak");
     bool success = false;
 
-    char* path_prefix = NULL;
-    char* state_name = NULL;
-    char* tmp_name = NULL;
-    char* bak_name = NULL;
-    char* thumb_name = NULL;
-    char* buff = NULL;
+    playdate->file->unlink(tmp_name, false);
+    SDFile* file = playdate->file->open(tmp_name, kFileWrite);
+    if (file)
+    {
+        success = playdate->file->write(file, buff, size) == size;
+        success = playdate->file->close(file) == 0 && success;
+    }
+
+    if (success)
+    {
+        playdate->file->unlink(bak_name, false);
+        playdate->file->rename(index_name, bak_name);
+        if (playdate->file->rename(tmp_name, index_name) != 0)
+        {
+            playdate->file->rename(bak_name, index_name);
+            success = false;
+        }
+    }
+
+    if (!success)
+    {
+        playdate->system->logToConsole("Failed to write save state index");
+        playdate->file->unlink(tmp_name, false);
+    }
+
+    cb_free(index_name);
+    cb_free(tmp_name);
+    cb_free(bak_name);
+    cb_free(buff);
+    return success;
+}
+
+// Reads the slot index; done once, when the scene is created. A valid index
+// is trusted as it is, and a slot is only compared with its .state file when
+// it's loaded (see state_index_refresh). Without one, each slot is re-derived
+// from its files later, in slack time or when it's first asked for (see
+// state_index_check).
+__section__(".rare") static void state_index_load(CB_GameScene* gameScene)
+{
+    CB_StateIndex* index = cb_calloc(1, sizeof(CB_StateIndex));
+    if (!index)
+        return;
+
+    index->valid = state_index_read(gameScene, index);
+    index->unchecked = index->valid ? 0 : (1u << SAVE_STATE_SLOT_COUNT) - 1;
+    gameScene->state_index = index;
+}
+
+// Writes the index if it has changed, unless it still has blank entries that
+// haven't been re-derived yet (which would be written as empty slots).
+__section__(".rare") static void state_index_sync(CB_GameScene* gameScene, CB_StateIndex* index)
+{
+    if (!index->dirty || (!index->valid && index->unchecked))
+        return;
+
+    if (state_index_write(gameScene, index))
+    {
+        index->dirty = false;
+        index->valid = true;
+    }
+}
+
+// Re-derives the slot's entry from its files, if it hasn't been yet; at most
+// one slot's files are read.
+__section__(".rare") static void state_index_check(
+    CB_GameScene* gameScene, CB_StateIndex* index, unsigned slot
+)
+{
+    const uint16_t bit = 1u << slot;
+    if (!(index->unchecked & bit))
+        return;
+    index->unchecked &= ~bit;
+
+    state_index_heal(gameScene, index, slot);
+    index->dirty = true;
+    playdate->system->logToConsole("Save state index: re-derived slot %u", slot);
+
+    if (!index->unchecked)
+    {
+        state_index_sync(gameScene, index);
+    }
+}
+
+__section__(".rare") static void state_index_check_next(CB_GameScene* gameScene)
+{
+    CB_StateIndex* index = gameScene->state_index;
+    for (unsigned slot = 0; slot < SAVE_STATE_SLOT_COUNT; ++slot)
+    {
+        if (index->unchecked & (1u << slot))
+        {
+            state_index_check(gameScene, index, slot);
+            return;
+        }
+    }
+}
+
+// The slot index, with the given slot's entry ready to show; NULL if it
+// couldn't be loaded. No file is touched unless the index had to be rebuilt.
+__section__(".rare") static CB_StateIndex* state_index_get(
+    CB_GameScene* gameScene, unsigned slot
+)
+{
+    CB_StateIndex* index = gameScene->state_index;
+    if (index && slot < SAVE_STATE_SLOT_COUNT)
+    {
+        state_index_check(gameScene, index, slot);
+    }
+    return index;
+}
+
+// Re-derives the slot's entry, once loading the slot has found it out of date.
+__section__(".rare") static void state_index_refresh(CB_GameScene* gameScene, unsigned slot)
+{
+    CB_StateIndex* index = gameScene->state_index;
+    if (!index || slot >= SAVE_STATE_SLOT_COUNT)
+        return;
+
+    playdate->system->logToConsole("Save state index is out of date for slot %u", slot);
+    index->unchecked &= ~(1u << slot);
+    state_index_heal(gameScene, index, slot);
+    index->dirty = true;
+    state_index_sync(gameScene, index);
+}
+
+__section__(".rare") static void state_index_free(CB_GameScene* gameScene)
+{
+    if (gameScene->state_index)
+    {
+        state_index_sync(gameScene, gameScene->state_index);
+        state_index_clear(gameScene->state_index);
+        cb_free(gameScene->state_index);
+        gameScene->state_index = NULL;
+    }
+}
+
+// records a save state just written
+__section__(".rare") static void state_index_update(CB_GameScene* gameScene, CB_SaveJob* job)
+{
+    CB_StateIndex* index = gameScene->state_index;
+    if (!index || job->slot >= SAVE_STATE_SLOT_COUNT)
+        return;
+
+    // (the file was just written, so there's nothing to check)
+    index->unchecked &= ~(1u << job->slot);
+
+    const struct StateHeader* header = (const struct StateHeader*)job->buff;
+    CB_StateIndexEntry* entry = &index->entries[job->slot];
+
+    char* path = save_state_path(gameScene, job->slot, "state");
+    uint32_t size;
+    entry->mtime = state_file_mtime(path, &size);
+    cb_free(path);
+
+    entry->size = job->size;
+    entry->crc = crc32_for_buffer((const unsigned char*)job->buff, job->size);
+    entry->timestamp = header->timestamp;
+    entry->script = header->script;
+
+    if (job->lcd)
+    {
+        uint8_t thumbnail[STATE_THUMBNAIL_SIZE];
+        save_state_thumbnail(job->lcd, thumbnail);
+        state_index_set_thumbnail(index, job->slot, thumbnail);
+    }
+    else
+    {
+        state_index_set_thumbnail(index, job->slot, NULL);
+    }
+
+    index->dirty = true;
+    state_index_sync(gameScene, index);
+}
+
+// Does one step of the job's work; returns false once it's finished
+// (whether or not successfully).
+__section__(".rare") static bool save_job_step(CB_GameScene* gameScene, CB_SaveJob* job)
+{
+    switch (job->step)
+    {
+    case SAVE_JOB_OPEN:
+    {
+        char* tmp_name = save_state_path(gameScene, job->slot, "tmp");
+
+        // Clean up any old temp file
+        playdate->file->unlink(tmp_name, false);
+
+        job->file = playdate->file->open(tmp_name, kFileWrite);
+        if (!job->file)
+        {
+            playdate->system->logToConsole(
+                "failed to open temp state file \"%s\": %s", tmp_name, playdate->file->geterr()
+            );
+        }
+        cb_free(tmp_name);
+
+        job->step = SAVE_JOB_WRITE;
+        job->failed = !job->file;
+        return job->file != NULL;
+    }
+
+    case SAVE_JOB_WRITE:
+    {
+        int slice = CB_MIN(SAVE_JOB_WRITE_SLICE, job->size - job->written);
+        int written = playdate->file->write(job->file, job->buff + job->written, slice);
+        if (written > 0)
+        {
+            job->written += written;
+        }
+
+        if (written != slice)
+        {
+            char* tmp_name = save_state_path(gameScene, job->slot, "tmp");
+            playdate->system->logToConsole(
+                "Error writing temp state file \"%s\" (wrote %u of %u bytes). "
+                "Aborting.",
+                tmp_name, (unsigned)job->written, (unsigned)job->size
+            );
+            playdate->file->close(job->file);
+            job->file = NULL;
+            playdate->file->unlink(tmp_name, false);
+            cb_free(tmp_name);
+            job->failed = true;
+            return false;
+        }
+
+        if (job->written == job->size)
+        {
+            job->step = SAVE_JOB_COMMIT;
+        }
+        return true;
+    }
+
+    case SAVE_JOB_COMMIT:
+    {
+        playdate->file->close(job->file);
+        job->file = NULL;
+
+        char* state_name = save_state_path(gameScene, job->slot, "state");
+        char* tmp_name = save_state_path(gameScene, job->slot, "tmp");
+        char* bak_name = save_state_path(gameScene, job->slot, "bak");
+        bool success = false;
+
+        // Rename files: .state -> .bak, then .tmp -> .state
+        playdate->system->logToConsole("Temp state saved, renaming files.");
+        playdate->file->unlink(bak_name, false);
+        playdate->file->rename(state_name, bak_name);
+        if (playdate->file->rename(tmp_name, state_name) == 0)
+        {
+            success = true;
+        }
+        else
+        {
+            playdate->system->logToConsole(
+                "CRITICAL: Failed to rename temp state file. Restoring "
+                "backup."
+            );
+            playdate->file->rename(bak_name, state_name);
+        }
+
+        cb_free(state_name);
+        cb_free(tmp_name);
+        cb_free(bak_name);
+
+        job->step = SAVE_JOB_THUMBNAIL;
+        job->failed = !success;
+        return success;
+    }
+
+    case SAVE_JOB_THUMBNAIL:
+    {
+        // (inessential, so we don't take safety precautions)
+        char* thumb_name = save_state_path(gameScene, job->slot, "thumb");
+        if (!job->lcd)
+        {
+            // don't leave the previous state's thumbnail behind
+            playdate->file->unlink(thumb_name, false);
+            cb_free(thumb_name);
+            job->step = SAVE_JOB_INDEX;
+            return true;
+        }
+
+        SDFile* file = playdate->file->open(thumb_name, kFileWrite);
+        cb_free(thumb_name);
+
+        if (file)
+        {
+            uint8_t thumbnail[STATE_THUMBNAIL_SIZE];
+            save_state_thumbnail(job->lcd, thumbnail);
+            playdate->file->write(file, thumbnail, sizeof(thumbnail));
+            playdate->file->close(file);
+        }
+        job->step = SAVE_JOB_INDEX;
+        return true;
+    }
+
+    case SAVE_JOB_INDEX:
+        state_index_update(gameScene, job);
+        return false;
+    }
+
+    return false;
+}
+
+// Does the next step of the current save job, moving on to the queued one
+// once it's finished.
+__section__(".rare") static void save_job_advance(CB_GameScene* gameScene)
+{
+    CB_SaveJob* job = gameScene->save_job;
+
+    float start = playdate->system->getElapsedTime();
+    bool more = save_job_step(gameScene, job);
+    job->worst_step = CB_MAX(job->worst_step, playdate->system->getElapsedTime() - start);
+    slack_worst_update(&job->slack_step, start);
+
+    if (more)
+        return;
+
+    if (job->failed)
+    {
+        // (the user was told the state was saved when it was captured)
+        char* msg;
+        playdate->system->formatString(
+            &msg, "Error saving state %u:\nit could not be written.", job->slot
+        );
+        const char* options[] = {"OK", NULL};
+        CB_presentModal(CB_Modal_new(msg, options, NULL, NULL)->scene);
+        cb_free(msg);
+    }
+    else
+    {
+        playdate->system->logToConsole(
+            "Save state %u: wrote %u KB over %u frames; worst frame %u ms, worst step %u ms",
+            job->slot, (unsigned)job->written / 1024, job->frames,
+            (unsigned)(job->worst_dt * 1000.0f + 0.5f),
+            (unsigned)(job->worst_step * 1000.0f + 0.5f)
+        );
+    }
+
+    gameScene->save_job = job->next;
+    save_job_free(job);
+}
+
+// finishes writing any save states at once, e.g. before reading state files
+__section__(".rare") static void save_job_flush(CB_GameScene* gameScene)
+{
+    while (gameScene->save_job)
+    {
+        save_job_advance(gameScene);
+    }
+}
+
+__section__(".rare") static unsigned get_save_state_timestamp_(
+    CB_GameScene* gameScene, unsigned slot
+)
+{
+    CB_SaveJob* job = save_job_for_slot(gameScene, slot);
+    if (job)
+    {
+        return ((struct StateHeader*)job->buff)->timestamp;
+    }
+
+    CB_StateIndex* index = state_index_get(gameScene, slot);
+    if (index && slot < SAVE_STATE_SLOT_COUNT)
+    {
+        return index->entries[slot].timestamp;
+    }
+
+    char* path = save_state_path(gameScene, slot, "state");
+
+    SDFile* file = playdate->file->open(path, kFileReadData);
+
+    cb_free(path);
+
+    if (!file)
+    {
+        return 0;
+    }
+
+    struct StateHeader header;
+    int read = playdate->file->read(file, &header, sizeof(header));
+    playdate->file->close(file);
+    if (read < sizeof(header))
+    {
+        return 0;
+    }
+    else
+    {
+        return header.timestamp;
+    }
+}
 
-    playdate->system->formatString(
-        &path_prefix, "%s/%s.%u", CB_statesPath, gameScene->base_filename, slot
-    );
+__section__(".rare") unsigned get_save_state_timestamp(CB_GameScene* gameScene, unsigned slot)
+{
+    return (unsigned)call_with_main_stack_2(get_save_state_timestamp_, gameScene, slot);
+}
 
-    playdate->system->formatString(&state_name, "%s.state", path_prefix);
-    playdate->system->formatString(&tmp_name, "%s.tmp", path_prefix);
-    playdate->system->formatString(&thumb_name, "%s.thumb", path_prefix);
-    playdate->system->formatString(&bak_name, "%s.bak", path_prefix);
+// Captures a save state, to be written out in the background.
+// returns true if successful
+__section__(".rare") static bool save_state_(CB_GameScene* gameScene, unsigned slot)
+{
+    playdate->system->logToConsole("save state %p", __builtin_frame_address(0));
 
-    // Clean up any old temp file
-    playdate->file->unlink(tmp_name, false);
+    CB_GameSceneContext* context = gameScene->context;
 
-    int save_size = gb_get_state_size(context->gb);
-    if (save_size <= 0)
+    CB_SaveJob* job = cb_calloc(1, sizeof(CB_SaveJob));
+    if (!job)
     {
-        playdate->system->logToConsole("Save state failed: invalid save size.");
-        goto cleanup;
+        playdate->system->logToConsole("Failed to allocate save state job");
+        return false;
     }
+    job->slot = slot;
 
-    buff = cb_malloc(save_size);
-    if (!buff)
+    job->buff = cb_malloc(gb_state_max_size(context->gb));
+    if (!job->buff)
     {
         playdate->system->logToConsole("Failed to allocate buffer for save state");
-        goto cleanup;
+        save_job_free(job);
+        return false;
     }
 
-    gb_state_save(context->gb, buff);
-
-    struct StateHeader* header = (struct StateHeader*)buff;
-    header->timestamp = playdate->system->getSecondsSinceEpoch(NULL);
-    header->script = (preferences_script_support && context->scene->script);
-
-    // Write the state to the temporary file
-    SDFile* file = playdate->file->open(tmp_name, kFileWrite);
-    if (!file)
+    job->size = gb_state_save(context->gb, job->buff);
+    if (job->size == 0)
     {
-        playdate->system->logToConsole(
-            "failed to open temp state file \"%s\": %s", tmp_name, playdate->file->geterr()
-        );
+        playdate->system->logToConsole("Save state failed: not enough memory to compress.");
+        save_job_free(job);
+        return false;
     }
-    else
-    {
-        int written = playdate->file->write(file, buff, save_size);
-        playdate->file->close(file);
 
-        // Verify that the temporary file was written correctly
-        if (written != save_size)
-        {
-            playdate->system->logToConsole(
-                "Error writing temp state file \"%s\" (wrote %d of %d bytes). "
-                "Aborting.",
-                tmp_name, written, save_size
-            );
-            playdate->file->unlink(tmp_name, false);
-        }
-        else
-        {
-            // Rename files: .state -> .bak, then .tmp -> .state
-            playdate->system->logToConsole("Temp state saved, renaming files.");
-            playdate->file->unlink(bak_name, false);
-            playdate->file->rename(state_name, bak_name);
-            if (playdate->file->rename(tmp_name, state_name) == 0)
-            {
-                success = true;
-            }
-            else
-            {
-                playdate->system->logToConsole(
-                    "CRITICAL: Failed to rename temp state file. Restoring "
-                    "backup."
-                );
-                playdate->file->rename(bak_name, state_name);
-            }
-        }
+    // give back what compression saved
+    char* shrunk = cb_realloc(job->buff, job->size);
+    if (shrunk)
+    {
+        job->buff = shrunk;
     }
 
+    struct StateHeader* header = (struct StateHeader*)job->buff;
+    header->timestamp = playdate->system->getSecondsSinceEpoch(NULL);
+    header->script = (preferences_script_support && context->scene->script);
+
     // we check playtime nonzero so that LCD has been updated at least once
     uint8_t* lcd = context->gb->lcd;
-    if (success && lcd && gameScene->playtime > 1)
+    if (lcd && gameScene->playtime > 1)
     {
-        // save thumbnail, too
-        // (inessential, so we don't take safety precautions)
-        SDFile* file = playdate->file->open(thumb_name, kFileWrite);
-
-        static const uint8_t dither_pattern[5] = {
-            0b00000000 ^ 0xFF, 0b01000100 ^ 0xFF, 0b10101010 ^ 0xFF,
-            0b11011101 ^ 0xFF, 0b11111111 ^ 0xFF,
-        };
-
-        if (file)
+        job->lcd = cb_malloc(SAVE_STATE_THUMBNAIL_H * LCD_WIDTH_PACKED);
+        if (job->lcd)
         {
-            for (unsigned y = 0; y < SAVE_STATE_THUMBNAIL_H; ++y)
-            {
-                uint8_t* line0 = lcd + y * LCD_WIDTH_PACKED;
-
-                u8 thumbline[(SAVE_STATE_THUMBNAIL_W + 7) / 8];
-                memset(thumbline, 0, sizeof(thumbline));
-
-                for (unsigned x = 0; x < SAVE_STATE_THUMBNAIL_W; ++x)
-                {
-                    // very bespoke dithering algorithm lol
-                    u8 p0 = __gb_get_pixel(line0, x);
-                    u8 p1 = __gb_get_pixel(line0, x ^ 1);
-
-                    u8 val = p0;
-                    if (val >= 2)
-                        val++;
-                    if (val == 1 && p1 >= 2)
-                        ++val;
-                    if (val == 3 && p1 < 2)
-                        --val;
-
-                    u8 pattern = dither_pattern[val];
-                    if (y % 2 == 1)
-                    {
-                        if (val == 2)
-                            pattern = (pattern >> 1) | (pattern << 7);
-                        else
-                            pattern = (pattern >> 2) | (pattern << 6);
-                    }
-
-                    u8 pix = (pattern >> (x % 8)) & 1;
+            memcpy(job->lcd, lcd, SAVE_STATE_THUMBNAIL_H * LCD_WIDTH_PACKED);
+        }
+    }
 
-                    thumbline[x / 8] |= pix << (7 - (x % 8));
-                }
+    // Join the queue, taking the place of a save to the same slot that's
+    // still waiting. (The one being written, at the front, is left to finish.)
+    CB_SaveJob** link = &gameScene->save_job;
+    if (*link)
+        link = &(*link)->next;
 
-                playdate->file->write(file, thumbline, sizeof(thumbline));
-            }
+    for (; *link; link = &(*link)->next)
+    {
+        CB_SaveJob* queued = *link;
+        if (queued->slot == slot)
+        {
+            playdate->system->logToConsole(
+                "Save state %u superseded before it was written.", queued->slot
+            );
+            job->next = queued->next;
+            save_job_free(queued);
+            break;
         }
-
-        playdate->file->close(file);
     }
+    *link = job;
 
-cleanup:
-    if (path_prefix)
-        cb_free(path_prefix);
-    if (state_name)
-        cb_free(state_name);
-    if (tmp_name)
-        cb_free(tmp_name);
-    if (bak_name)
-        cb_free(bak_name);
-    if (thumb_name)
-        cb_free(thumb_name);
-    if (buff)
-        cb_free(buff);
-
-    gameScene->isCurrentlySaving = false;
-    return success;
+    return true;
 }
 
 // returns true if successful
@@ -2964,10 +4969,23 @@ __section__(".rare") bool load_state_thumbnail_(
     CB_GameScene* gameScene, unsigned slot, uint8_t* out
 )
 {
-    char* path;
-    playdate->system->formatString(
-        &path, "%s/%s.%u.thumb", CB_statesPath, gameScene->base_filename, slot
-    );
+    CB_SaveJob* job = save_job_for_slot(gameScene, slot);
+    if (job)
+    {
+        if (!job->lcd)
+            return false;
+
+        save_state_thumbnail(job->lcd, out);
+        return true;
+    }
+
+    CB_StateIndex* index = state_index_get(gameScene, slot);
+    if (index && slot < SAVE_STATE_SLOT_COUNT)
+    {
+        return state_index_get_thumbnail(index, slot, out);
+    }
+
+    char* path = save_state_path(gameScene, slot, "thumb");
 
     SDFile* file = playdate->file->open(path, kFileReadData);
 
@@ -2978,7 +4996,7 @@ __section__(".rare") bool load_state_thumbnail_(
         return 0;
     }
 
-    int count = SAVE_STATE_THUMBNAIL_H * ((SAVE_STATE_THUMBNAIL_W + 7) / 8);
+    int count = STATE_THUMBNAIL_SIZE;
     int read = playdate->file->read(file, out, count);
     playdate->file->close(file);
 
@@ -2994,6 +5012,10 @@ __section__(".rare") bool load_state_thumbnail(CB_GameScene* gameScene, unsigned
 // returns true if successful
 __section__(".rare") bool load_state(CB_GameScene* gameScene, unsigned slot)
 {
+    save_job_flush(gameScene);
+
+    uint32_t start_ms = playdate->system->getCurrentTimeMilliseconds();
+
     gameScene->playtime = 0;
     CB_GameSceneContext* context = gameScene->context;
     char* state_name;
@@ -3002,13 +5024,19 @@ __section__(".rare") bool load_state(CB_GameScene* gameScene, unsigned slot)
     );
     bool success = false;
 
-    int save_size = gb_get_state_size(context->gb);
     SDFile* file = playdate->file->open(state_name, kFileReadData);
     if (!file)
     {
         playdate->system->logToConsole(
             "failed to open save state file \"%s\": %s", state_name, playdate->file->geterr()
         );
+
+        // (the index may still list it)
+        CB_StateIndex* index = gameScene->state_index;
+        if (index && slot < SAVE_STATE_SLOT_COUNT && index->entries[slot].size > 0)
+        {
+            state_index_refresh(gameScene, slot);
+        }
     }
     else
     {
@@ -3078,6 +5106,14 @@ __section__(".rare") bool load_state(CB_GameScene* gameScene, unsigned slot)
                             );
                         }
 
+                        CB_StateIndex* index = gameScene->state_index;
+                        if (index && slot < SAVE_STATE_SLOT_COUNT &&
+                            index->entries[slot].crc !=
+                                crc32_for_buffer((const unsigned char*)buff, save_size))
+                        {
+                            state_index_refresh(gameScene, slot);
+                        }
+
                         const char* res = gb_state_load(context->gb, buff, save_size);
                         if (res)
                         {
@@ -3099,9 +5135,251 @@ __section__(".rare") bool load_state(CB_GameScene* gameScene, unsigned slot)
     }
 
     cb_free(state_name);
+
+    if (success)
+    {
+        // (reported along with the first frame after it; see CB_GameScene_update)
+        gameScene->state_load_ms =
+            CB_MAX(1, playdate->system->getCurrentTimeMilliseconds() - start_ms);
+    }
     return success;
 }
 
+// (per the game's settings, so only meaningful while the scene's are loaded)
+static bool suspend_state_enabled(CB_GameScene* gameScene)
+{
+    return preferences_suspend == SUSPEND_ALL ||
+           (preferences_suspend == SUSPEND_ON && !gameScene->cartridge_has_battery);
+}
+
+// Writes the suspend state, first saving cart RAM so that the two agree. If
+// the setting is off, deletes any suspend state left from before instead.
+__section__(".rare") static void suspend_state_write_(CB_GameScene* gameScene)
+{
+    CB_GameSceneContext* context = gameScene->context;
+    struct gb_s* gb = context->gb;
+
+    if (gameScene->state != CB_GameSceneStateLoaded)
+    {
+        return;
+    }
+
+    if (!suspend_state_enabled(gameScene))
+    {
+        char* suspend_name = state_index_path(gameScene, "suspend");
+        playdate->file->unlink(suspend_name, false);
+        cb_free(suspend_name);
+        return;
+    }
+
+    if (!gameScene->save_data_loaded_successfully)
+    {
+        return;
+    }
+
+    uint32_t start_ms = playdate->system->getCurrentTimeMilliseconds();
+
+    if (gameScene->cartridge_has_battery)
+    {
+        gb_save_to_disk_(gb, true);
+        if (gb->direct.sram_dirty)
+        {
+            playdate->system->logToConsole("Not suspending: cartridge save data wasn't saved.");
+            return;
+        }
+    }
+
+    char* buff = cb_malloc(sizeof(CB_SuspendHeader) + gb_state_max_size(gb));
+    if (!buff)
+    {
+        playdate->system->logToConsole("Not suspending: out of memory.");
+        return;
+    }
+
+    char* state = buff + sizeof(CB_SuspendHeader);
+    uint32_t size = gb_state_save(gb, state);
+    if (size == 0)
+    {
+        playdate->system->logToConsole("Not suspending: out of memory.");
+        cb_free(buff);
+        return;
+    }
+
+    struct StateHeader* state_header = (struct StateHeader*)state;
+    state_header->timestamp = playdate->system->getSecondsSinceEpoch(NULL);
+    state_header->script = (preferences_script_support && gameScene->script);
+
+    CB_SuspendHeader header = {
+        SUSPEND_MAGIC,
+        gameScene->cartridge_has_battery ? crc32_for_buffer(gb->gb_cart_ram, gb->gb_cart_ram_size)
+                                         : 0,
+        size, crc32_for_buffer((const unsigned char*)state, size)
+    };
+    memcpy(buff, &header, sizeof(header));
+
+    char* suspend_name = state_index_path(gameScene, "suspend");
+    char* tmp_name = state_index_path(gameScene, "suspend.tmp");
+
+    bool success = false;
+    playdate->file->unlink(tmp_name, false);
+    SDFile* file = playdate->file->open(tmp_name, kFileWrite);
+    if (file)
+    {
+        int total = sizeof(header) + size;
+        success = playdate->file->write(file, buff, total) == total;
+        success = playdate->file->close(file) == 0 && success;
+    }
+
+    if (success)
+    {
+        // (a missing suspend state only costs a cold start)
+        playdate->file->unlink(suspend_name, false);
+        success = playdate->file->rename(tmp_name, suspend_name) == 0;
+    }
+
+    if (success)
+    {
+        playdate->system->logToConsole(
+            "Suspended: %u KB in %u ms", (unsigned)(sizeof(header) + size) / 1024,
+            (unsigned)(playdate->system->getCurrentTimeMilliseconds() - start_ms)
+        );
+    }
+    else
+    {
+        playdate->system->logToConsole("Failed to write suspend state");
+        playdate->file->unlink(tmp_name, false);
+    }
+
+    cb_free(suspend_name);
+    cb_free(tmp_name);
+    cb_free(buff);
+}
+
+__section__(".rare") static void suspend_state_write(CB_GameScene* gameScene)
+{
+    call_with_main_stack_1(suspend_state_write_, gameScene);
+}
+
+// Restores the suspend state, if there is one and it's no older than the
+// cartridge save data just loaded. Returns true if restored.
+__section__(".rare") static bool suspend_state_resume(CB_GameScene* gameScene)
+{
+    CB_GameSceneContext* context = gameScene->context;
+    struct gb_s* gb = context->gb;
+
+    uint32_t start_ms = playdate->system->getCurrentTimeMilliseconds();
+
+    char* suspend_name = state_index_path(gameScene, "suspend");
+    SDFile* file = playdate->file->open(suspend_name, kFileReadData);
+    if (!file)
+    {
+        cb_free(suspend_name);
+        return false;
+    }
+
+    CB_SuspendHeader header;
+    char* state = NULL;
+    const char* error = NULL;
+
+    if (read_fully(file, &header, sizeof(header)) != sizeof(header) ||
+        header.magic != SUSPEND_MAGIC)
+    {
+        error = "not a suspend state";
+    }
+    else if (gameScene->cartridge_has_battery &&
+             header.sram_crc != crc32_for_buffer(gb->gb_cart_ram, gb->gb_cart_ram_size))
+    {
+        // e.g. the game was saved by another version, or the save file
+        // was replaced; resuming would roll the save data back.
+        error = "older than the cartridge save data";
+    }
+    else if (!(state = cb_malloc(header.size)))
+    {
+        error = "out of memory";
+    }
+    else if (read_fully(file, state, header.size) != header.size ||
+             crc32_for_buffer((const unsigned char*)state, header.size) != header.crc)
+    {
+        error = "damaged";
+    }
+    playdate->file->close(file);
+
+    if (!error)
+    {
+        error = gb_state_load(gb, state, header.size);
+    }
+
+    if (error)
+    {
+        playdate->system->logToConsole("Not resuming: suspend state %s", error);
+        playdate->file->unlink(suspend_name, false);
+    }
+    else
+    {
+        // the clock kept running while suspended
+        unsigned int suspended_at = ((struct StateHeader*)state)->timestamp;
+        unsigned int now = playdate->system->getSecondsSinceEpoch(NULL);
+        if (gameScene->cartridge_has_rtc && now > suspended_at)
+        {
+            gb_catch_up_rtc_direct(gb, now - suspended_at);
+        }
+
+        playdate->system->logToConsole(
+            "Resumed from suspend state in %u ms",
+            (unsigned)(playdate->system->getCurrentTimeMilliseconds() - start_ms)
+        );
+    }
+
+    cb_free(state);
+    cb_free(suspend_name);
+    return !error;
+}
+
+// reports how often the guest lagged, and how much overclocking was used
+__section__(".rare") static void log_lag_stats(struct gb_s* gb)
+{
+    if (gb->lag.frames == 0)
+        return;
+
+    playdate->system->logToConsole(
+        "Lag frames: %u / %u (%u%%); overclocked frames: %u (%u%%)", gb->lag.lag_frames,
+        gb->lag.frames, (unsigned)(100ull * gb->lag.lag_frames / gb->lag.frames),
+        gb->lag.overclocked_frames, (unsigned)(100ull * gb->lag.overclocked_frames / gb->lag.frames)
+    );
+
+    CB_GameSceneContext* context = gb->direct.priv;
+    if (context->scene->audioEnabled)
+    {
+        struct audio_stats stats;
+        audio_get_stats(&stats);
+        playdate->system->logToConsole(
+            "Audio underruns: %u; overruns: %u; dropped writes: %u", stats.underruns,
+            stats.overruns, stats.overflows
+        );
+    }
+
+    if (preferences_late_input)
+    {
+        playdate->system->logToConsole(
+            "Late input polls: %u in %u frames", context->scene->late_input_polls, gb->lag.frames
+        );
+    }
+
+    CB_Rewind* rewind = context->scene->rewind;
+    if (rewind)
+    {
+        uint32_t used = rewind->wrapped ? rewind->end - rewind->tail + rewind->head
+                                        : rewind->head - rewind->tail;
+        playdate->system->logToConsole(
+            "Rewind: %u s held in %u / %u KB; %u bytes of history per second; capture takes "
+            "%u us per frame",
+            rewind->frames / 60, used / 1024, REWIND_BUDGET / 1024,
+            (unsigned)(rewind->bytes_per_frame * VERTICAL_SYNC),
+            (unsigned)(rewind->capture_cost * 1000000.0f)
+        );
+    }
+}
+
 __section__(".rare") static void CB_GameScene_event(void* object, PDSystemEvent event, uint32_t arg)
 {
     CB_GameScene* gameScene = object;
@@ -3112,19 +5390,36 @@ __section__(".rare") static void CB_GameScene_event(void* object, PDSystemEvent
     case kEventLock:
     case kEventPause:
         audioGameScene = NULL;
+        log_lag_stats(context->gb);
 
         DTCM_VERIFY();
         if (gameScene->cartridge_has_battery)
         {
             call_with_user_stack_1(CB_GameScene_menu, gameScene);
         }
+        if (event == kEventLock)
+        {
+            suspend_state_write(gameScene);
+        }
         // fallthrough
     case kEventTerminate:
         DTCM_VERIFY();
-        if (context->gb->direct.sram_dirty && gameScene->save_data_loaded_successfully)
+        save_job_flush(gameScene);
+        if (gameScene->save_data_loaded_successfully)
         {
-            playdate->system->logToConsole("saving (system event)");
-            gb_save_to_disk(context->gb);
+            if (context->gb->direct.sram_dirty)
+            {
+                playdate->system->logToConsole("saving (system event)");
+            }
+            // (also finishes a save in progress)
+            if (event == kEventTerminate)
+            {
+                gb_save_to_disk_compact(context->gb);
+            }
+            else
+            {
+                gb_save_to_disk(context->gb);
+            }
         }
         DTCM_VERIFY();
         break;
@@ -3189,6 +5484,13 @@ static void CB_GameScene_free(void* object)
 
     prefs_locked_by_script = 0;
 
+    save_job_flush(gameScene);
+    log_lag_stats(context->gb);
+
+    // (while the game's own settings are still loaded; also saves cart RAM,
+    // for a cartridge with a battery)
+    suspend_state_write(gameScene);
+
     preferences_read_from_disk(CB_globalPrefsPath);
     preferences_per_game = 0;
     preferences_save_state_slot = 0;
@@ -3213,7 +5515,7 @@ static void CB_GameScene_free(void* object)
 
     CB_Scene_free(gameScene->scene);
 
-    gb_save_to_disk(context->gb);
+    gb_save_to_disk_compact(context->gb);
 
     gb_reset(context->gb);
 
@@ -3223,6 +5525,20 @@ static void CB_GameScene_free(void* object)
     cb_free(gameScene->settings_filename);
     cb_free(gameScene->name_short);
 
+    if (gameScene->run_ahead_snapshot)
+    {
+        cb_free(gameScene->run_ahead_snapshot);
+    }
+
+    rewind_free(gameScene);
+    state_index_free(gameScene);
+
+    if (gameScene->sram_journal)
+    {
+        cb_free(gameScene->sram_journal->pending);
+        cb_free(gameScene->sram_journal);
+    }
+
     if (context->rom)
     {
         cb_free(context->rom);
@@ -140,11 +140,50 @@ typedef struct CB_GameScene
     bool crank_turbo_b_active;
     bool crank_was_docked;
 
+    // fast-forward multiplier requested by the crank (1: off),
+    // and the multiplier actually achieved relative to real time.
+    float fast_forward_level;
+    float fast_forward_achieved;
+    uint8_t fast_forward_label; // achieved multiplier x2, as last drawn
+
+    // in-memory snapshot used by run-ahead, and the time (s) run-ahead takes per frame;
+    // run-ahead is off for the rest of the session if the snapshot can't be allocated
+    uint8_t *run_ahead_snapshot;
+    float run_ahead_cost;
+    bool run_ahead_unavailable;
+
+    // rewind history (kept while the crank is in rewind mode), updates left
+    // to keep rewinding once the crank stops turning backwards, and the
+    // seconds of history held as last drawn; rewind is off for the rest of
+    // the session if the history can't be allocated
+    struct CB_Rewind *rewind;
+    unsigned rewind_hold;
+    uint8_t rewind_label;
+    bool rewind_unavailable;
+
+    // number of times the core has asked for fresh input mid-frame (late input)
+    unsigned late_input_polls;
+
     // time since started or last save/load state
     unsigned playtime;
 
     bool isCurrentlySaving;
 
+    // save states waiting to be written out in the background, oldest (the
+    // one being written) first
+    struct CB_SaveJob *save_job;
+
+    // save state slot index, once read
+    struct CB_StateIndex *state_index;
+
+    // time (ms) the last state load took, until the first frame after it
+    // has been drawn (0 otherwise)
+    uint32_t state_load_ms;
+
+    // journal of cart RAM pages written since the save file was last
+    // written in full (NULL if the cartridge has no RAM)
+    struct CB_SramJournal *sram_journal;
+
     int interlace_tendency_counter;
     int interlace_lock_frames_remaining;
     int previous_scale_line_index;
@@ -160,6 +199,10 @@ void CB_GameScene_didSelectLibrary(void* userdata);
 unsigned get_save_state_timestamp(CB_GameScene *gameScene, unsigned slot);
 bool load_state_thumbnail(CB_GameScene *gameScene, unsigned slot, uint8_t* out);
 
+// dithers a packed LCD (e.g. gb->lcd) down to a 1-bit thumbnail of
+// SAVE_STATE_THUMBNAIL_W x SAVE_STATE_THUMBNAIL_H
+void save_state_thumbnail(const uint8_t* lcd, uint8_t* out);
+
 struct CB_Game;
 void show_game_script_info(const char* rompath, const char* name_short);
 
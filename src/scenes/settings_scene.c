@@ -166,6 +166,7 @@ CB_SettingsScene* CB_SettingsScene_new(CB_GameScene* gameScene, CB_LibraryScene*
 
     settingsScene->initial_sound_mode = preferences_sound_mode;
     settingsScene->initial_sample_rate = preferences_sample_rate;
+    settingsScene->initial_sound_render = preferences_sound_render;
     settingsScene->initial_per_game = preferences_per_game;
 
     if (gameScene)
@@ -320,16 +321,20 @@ static void CB_SettingsScene_attemptDismiss(CB_SettingsScene* settingsScene)
 
 static const char* sound_mode_labels[] = {"Off", "Fast", "Accurate"};
 static const char* off_on_labels[] = {"Off", "On"};
+static const char* suspend_labels[] = {"Off", "On", "All games"};
 static const char* gb_button_labels[] = {"None", "Start", "Select", "A", "B"};
-static const char* crank_mode_labels[] = {"Start/Select", "Turbo A/B", "Turbo B/A", "Off"};
-static const char* sample_rate_labels[] = {"High", "Medium", "Low"};
+static const char* crank_mode_labels[] = {"Start/Select", "Turbo A/B", "Turbo B/A", "Off",
+                                           "Fast-Fwd", "Rewind"};
+static const char* sample_rate_labels[] = {"High", "Medium", "Low", "Lowest"};
+static const char* sound_render_labels[] = {"Live", "Per frame"};
 static const char* dynamic_rate_labels[] = {"Off", "On", "Auto"};
-static const char* fps_labels[] = {"Off", "On", "Playdate"};
+static const char* fps_labels[] = {"Off", "On", "Playdate", "Pacing"};
 static const char* slot_labels[] = {"[slot 0]", "[slot 1]", "[slot 2]", "[slot 3]", "[slot 4]",
                                     "[slot 5]", "[slot 6]", "[slot 7]", "[slot 8]", "[slot 9]"};
 static const char* dither_pattern_labels[] = {"Staggered", "Grid",          "Staggered (L)",
                                               "Grid (L)",  "Staggered (D)", "Grid (D)"};
-static const char* overclock_labels[] = {"Off", "x2", "x4"};
+static const char* overclock_labels[] = {"Off", "x2", "x4", "Auto x2", "Auto x4"};
+static const char* run_ahead_labels[] = {"Off", "1 frame", "2 frames", "3 frames"};
 static const char* dynamic_level_labels[] = {"1", "2", "3", "4",  "5", "6",
                                              "7", "8", "9", "10", "11"};
 static const char* settings_scope_labels[] = {"Global", "Game"};
@@ -464,7 +469,7 @@ static OptionsMenuEntry* getOptionsEntries(CB_SettingsScene* scene)
             ? libraryScene->games->items[libraryScene->listView->selectedItem]
             : NULL;
 
-    int max_entries = 30;  // we can overshoot, it's ok
+    int max_entries = 44;  // we can overshoot, it's ok
     OptionsMenuEntry* entries = cb_malloc(sizeof(OptionsMenuEntry) * max_entries);
     if (!entries)
         return NULL;
@@ -579,9 +584,24 @@ static OptionsMenuEntry* getOptionsEntries(CB_SettingsScene* scene)
             "Adjusts audio quality.\nHigher values may impact\nperformance.\n \n"
             "High:\nBest quality (44.1 kHz)\n \n"
             "Medium:\nGood quality (22.1 kHz)\n \n"
-            "Low:\nReduced quality (14.7 kHz)",
+            "Low:\nReduced quality (14.7 kHz)\n \n"
+            "Lowest:\nMinimal quality (11.0 kHz)",
         .pref_var = &preferences_sample_rate,
-        .max_value = 3,
+        .max_value = 4,
+        .on_press = NULL,
+    };
+
+    // sound render
+    entries[++i] = (OptionsMenuEntry){
+        .name = "Render audio",
+        .values = sound_render_labels,
+        .description =
+            "When audio is generated.\n \n"
+            "Live:\nAs it plays, with the\nlowest overhead.\n \n"
+            "Per frame:\nAlong with each frame,\nthen buffered. Output is\n"
+            "reproducible, and playback\nis cheaper.",
+        .pref_var = &preferences_sound_render,
+        .max_value = 2,
         .on_press = NULL,
     };
 
@@ -729,9 +749,11 @@ static OptionsMenuEntry* getOptionsEntries(CB_SettingsScene* scene)
         .description =
             "Assign a (turbo) function\nto the crank.\n \nStart/Select:\nCW for "
             "Start, CCW for Select.\n \nTurbo A/B:\nCW for A, CCW for B.\n \nTurbo "
-            "B/A:\nCW for B, CCW for A.\n \n",
+            "B/A:\nCW for B, CCW for A.\n \nFast-Fwd:\nTurn either way to\nrun the game faster;\n"
+            "the faster you turn,\nthe faster it runs.\n \nRewind:\nTurn backwards to\n"
+            "step back through\nthe last few seconds.\n \n",
         .pref_var = &preferences_crank_mode,
-        .max_value = 4,
+        .max_value = 6,
         .on_press = NULL
     };
 
@@ -764,9 +786,53 @@ static OptionsMenuEntry* getOptionsEntries(CB_SettingsScene* scene)
         .description =
             "Attempt to reduce lag\nin emulated device, but\nthe Playdate must work\nharder to achieve this.\n \n"
             "Allows the emulated CPU\nto run much faster\nduring VBLANK.\n \n"
-            "Not a guaranteed way to\nimprove performance,\nand may introduce\ninaccuracies."
+            "Not a guaranteed way to\nimprove performance,\nand may introduce\ninaccuracies.\n \n"
+            "Auto only overclocks\nwhile the game is\nlagging, up to the\ngiven limit."
         ,
         .pref_var = &preferences_overclock,
+        .max_value = 5,
+        .on_press = NULL
+    };
+
+    // run-ahead
+    entries[++i] = (OptionsMenuEntry){
+        .name = "Run-ahead",
+        .values = run_ahead_labels,
+        .description =
+            "Reduces input lag by\nsecretly running a few\nframes ahead and showing\nthe result.\n \n"
+            "Costs one extra emulated\nframe per step; set Show\nFPS to Pacing to see the\ncost in ms.\n \n"
+            "Paused during the boot\nsequence and when a\ngame script is active."
+        ,
+        .pref_var = &preferences_run_ahead,
+        .max_value = 4,
+        .on_press = NULL
+    };
+
+    // late input
+    entries[++i] = (OptionsMenuEntry){
+        .name = "Late input",
+        .values = off_on_labels,
+        .description =
+            "Reads the buttons again\nat the moment the game\nfirst checks them each\nframe, rather than before\nthe frame starts.\n \n"
+            "Reduces input lag by up\nto one frame at almost\nno cost."
+        ,
+        .pref_var = &preferences_late_input,
+        .max_value = 2,
+        .on_press = NULL
+    };
+
+    // suspend
+    entries[++i] = (OptionsMenuEntry){
+        .name = "Resume game",
+        .values = suspend_labels,
+        .description =
+            "On leaving the game,\nremembers exactly where\nit was, and picks up from\nthere the next time it's\nlaunched.\n \n"
+            "On: not for games with\ntheir own save data.\n \n"
+            "All games: WARNING! For\na game with its own save\ndata, this is a save state.\n"
+            "Mixing the two can lose\nyour save data. Use at\nyour own risk.\n \n"
+            "Not used if the game's\nsave data has changed\nin the meantime."
+        ,
+        .pref_var = &preferences_suspend,
         .max_value = 3,
         .on_press = NULL
     };
@@ -885,10 +951,11 @@ static OptionsMenuEntry* getOptionsEntries(CB_SettingsScene* scene)
         .values = fps_labels,
         .description =
             "Displays the current\nframes-per-second\non screen.\n \n"
-            "Choice of displaying\nPlaydate screen refreshes\nor emulated frames.\n(These can differ if 30 FPS\nmode is enabled.)"
+            "Choice of displaying\nPlaydate screen refreshes\nor emulated frames.\n(These can differ if 30 FPS\nmode is enabled.)\n \n"
+            "Pacing also shows the\npercentage of frames\nwhich missed their\ndeadline."
         ,
         .pref_var = &preferences_display_fps,
-        .max_value = 3,
+        .max_value = 4,
         .on_press = NULL
     };
 
@@ -1673,7 +1740,8 @@ static void CB_SettingsScene_free(void* object)
     {
         bool audio_settings_changed =
             (settingsScene->initial_sound_mode != preferences_sound_mode) ||
-            (settingsScene->initial_sample_rate != preferences_sample_rate);
+            (settingsScene->initial_sample_rate != preferences_sample_rate) ||
+            (settingsScene->initial_sound_render != preferences_sound_render);
 
         CB_GameScene_apply_settings(settingsScene->gameScene, audio_settings_changed);
         settingsScene->gameScene->audioLocked = settingsScene->wasAudioLocked;
@@ -37,6 +37,7 @@ typedef struct CB_SettingsScene
 
     int initial_sound_mode;
     int initial_sample_rate;
+    int initial_sound_render;
     int initial_per_game;
     preference_t* immutable_settings;
 
@@ -201,6 +201,11 @@ uint32_t crc32_for_buffer(const unsigned char* buf, size_t len)
     return crc ^ 0xffffffffL;
 }
 
+uint32_t crc32_continue(uint32_t crc, const unsigned char* buf, size_t len)
+{
+    return update_crc32(crc ^ 0xffffffffL, buf, len) ^ 0xffffffffL;
+}
+
 bool cb_calculate_crc32(const char* filepath, FileOptions fopts, uint32_t* o_crc)
 {
     if (!crc32_table_generated)
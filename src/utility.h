@@ -138,6 +138,10 @@ bool cb_calculate_crc32(const char* filepath, FileOptions fopts, uint32_t* crc);
 
 uint32_t crc32_for_buffer(const unsigned char* buf, size_t len);
 
+// extends a CRC32 (e.g. from crc32_for_buffer, or 0 for none yet) over
+// more data
+uint32_t crc32_continue(uint32_t crc, const unsigned char* buf, size_t len);
+
 char* cb_find_cover_art_path_from_list(
     const CB_Array* available_covers, const char* rom_basename_no_ext,
     const char* rom_clean_basename_no_ext